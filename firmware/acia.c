@@ -0,0 +1,372 @@
+/*
+ * 6551 ACIA emulation and telnet bridge for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "config.h"
+#include "picowi.h"
+#include "mememul.h"
+#include "acia.h"
+
+// Telnet commands and options
+//
+#define TN_IAC              255
+#define TN_DONT             254
+#define TN_DO               253
+#define TN_WONT             252
+#define TN_WILL             251
+#define TN_SB               250
+#define TN_SE               240
+#define TN_ECHO             1
+#define TN_SGA              3
+
+typedef enum { TN_STATE_DATA, TN_STATE_IAC, TN_STATE_OPTION, TN_STATE_SB, TN_STATE_SB_IAC } tn_state_t;
+
+// Rings between the telnet client, on core 0, and the 6502, on core 1. Each
+// index is written by a single core, and they are free running counters
+//
+static uint8_t rx_ring[ACIA_RING_SIZE];
+static uint8_t tx_ring[ACIA_RING_SIZE];
+static volatile uint32_t rx_head, rx_tail;
+static volatile uint32_t tx_head, tx_tail;
+static volatile bool connected;
+
+// Core 1 side
+//
+static bool rdrf;                       // A received byte is in the data register
+static uint8_t rx_data;                 // And this is it
+
+// Core 0 side
+//
+static struct {
+    int         sock;                   // Telnet client socket, -1 if none
+    tn_state_t  state;                  // Telnet command parser
+    bool        cr;                     // Last data byte was a CR
+    bool        greet;                  // Option negotiation pending
+    uint32_t    tx_oset;                // Stream offset of the data in tx
+    int         txlen;
+    uint8_t     tx[ACIA_SEGMENT_LEN];   // Copy of the last segment, for retransmission
+} telnet = { .sock = -1 };
+
+static inline volatile uint8_t *acia_reg( uint16_t base, int reg )
+{
+    return ( volatile uint8_t * )&mem_map[base + reg];
+}
+
+static void acia_update_status( uint16_t base )
+{
+    uint8_t status = 0;
+
+    if ( !connected || tx_head - tx_tail < ACIA_RING_SIZE )
+    {
+        status |= ACIA_TDRE;
+    }
+
+    if ( rdrf )
+    {
+        status |= ACIA_RDRF;
+    }
+
+    if ( !connected )
+    {
+        status |= ACIA_DCD;
+    }
+
+    if ( *acia_reg( base, ACIA_STATUS ) != status )
+    {
+        *acia_reg( base, ACIA_STATUS ) = status;
+    }
+}
+
+// The bus monitor follows a 4 byte aligned block, so the registers must be
+// aligned as on a real 6551
+//
+bool acia_enable( uint16_t base )
+{
+    if ( base % MEMEMUL_BUSMON_BLOCK )
+    {
+        return ( false );
+    }
+
+    rdrf = false;
+    rx_tail = rx_head;
+    acia_update_status( base );
+
+    mememul_busmon_start( base );
+
+    return ( true );
+}
+
+void acia_disable( void )
+{
+    mememul_busmon_stop();
+}
+
+// Called from core 1 on each 6502 write to the registers
+//
+void acia_write( uint16_t base, int reg, uint8_t value )
+{
+    switch ( reg )
+    {
+        case ACIA_DATA:
+            // With no client, the data is dropped, as with nothing connected
+            // to a serial line. If the ring is full, the 6502 did not wait
+            // for TDRE. The transmit and receive registers share the address,
+            // so the received byte is put back
+            //
+            if ( connected && tx_head - tx_tail < ACIA_RING_SIZE )
+            {
+                tx_ring[tx_head % ACIA_RING_SIZE] = value;
+                __sync_synchronize();
+                ++tx_head;
+            }
+            *acia_reg( base, ACIA_DATA ) = rx_data;
+            break;
+
+        case ACIA_STATUS:
+            *acia_reg( base, ACIA_COMMAND ) &= ACIA_RESET_MASK;
+            break;
+
+        default:
+            return;
+    }
+
+    acia_update_status( base );
+}
+
+// Called from core 1 on every loop. A read of the data register takes the
+// received byte, and the next one is loaded from the ring
+//
+void acia_poll( uint16_t base )
+{
+    int reg;
+    bool read;
+
+    while ( mememul_busmon_next( &reg, &read ) )
+    {
+        if ( read && reg == ACIA_DATA )
+        {
+            rdrf = false;
+        }
+    }
+
+    if ( !rdrf && rx_tail != rx_head )
+    {
+        __sync_synchronize();
+        rx_data = rx_ring[rx_tail % ACIA_RING_SIZE];
+        ++rx_tail;
+
+        // The data must be in place before the 6502 sees RDRF
+        //
+        *acia_reg( base, ACIA_DATA ) = rx_data;
+        __sync_synchronize();
+        rdrf = true;
+    }
+
+    acia_update_status( base );
+}
+
+// Take the data from the client, without the telnet commands. Line ends
+// are sent by clients as CR LF or CR NUL, and are passed as a single CR.
+// Returns -1 if it does not fit in the ring, so it is not acknowledged and
+// the client sends it again
+//
+static int acia_telnet_rx( const uint8_t *data, int len )
+{
+    uint32_t head = rx_head;
+
+    if ( ACIA_RING_SIZE - ( head - rx_tail ) < len )
+    {
+        return ( -1 );
+    }
+
+    for ( int i = 0; i < len; ++i )
+    {
+        uint8_t c = data[i];
+
+        switch ( telnet.state )
+        {
+            case TN_STATE_DATA:
+                if ( c == TN_IAC )
+                {
+                    telnet.state = TN_STATE_IAC;
+                    continue;
+                }
+                break;
+
+            case TN_STATE_IAC:
+                telnet.state = c == TN_SB ? TN_STATE_SB
+                             : c >= TN_WILL && c <= TN_DONT ? TN_STATE_OPTION
+                             : TN_STATE_DATA;
+                if ( c != TN_IAC )
+                {
+                    continue;
+                }
+                break;                      // Escaped 255 data byte
+
+            case TN_STATE_OPTION:
+                telnet.state = TN_STATE_DATA;
+                continue;
+
+            case TN_STATE_SB:
+                if ( c == TN_IAC )
+                {
+                    telnet.state = TN_STATE_SB_IAC;
+                }
+                continue;
+
+            case TN_STATE_SB_IAC:
+                telnet.state = c == TN_SE ? TN_STATE_DATA : TN_STATE_SB;
+                continue;
+        }
+
+        if ( telnet.cr && ( c == '\n' || c == '\0' ) )
+        {
+            telnet.cr = false;
+            continue;
+        }
+
+        telnet.cr = c == '\r';
+        rx_ring[head++ % ACIA_RING_SIZE] = c;
+    }
+
+    // The data must be in place before core 1 sees the new head
+    //
+    __sync_synchronize();
+    rx_head = head;
+
+    return ( 0 );
+}
+
+// Handler for the telnet port. Gets the data from the client and, when
+// polled, sends the data written by the 6502
+//
+static int acia_telnet_handler( int sock, char *req, int oset )
+{
+    static const uint8_t options[] = { TN_IAC, TN_WILL, TN_ECHO, TN_IAC, TN_WILL, TN_SGA };
+
+    NET_SOCKET *ts = &net_sockets[sock];
+    uint32_t pos = ts->seq - ts->start_seq;     // Stream offset of the next byte to send
+    uint32_t head;
+
+    if ( telnet.sock != sock )
+    {
+        // New client. The 6502 echoes, and there is no line buffering
+        //
+        telnet.sock = sock;
+        telnet.state = TN_STATE_DATA;
+        telnet.cr = false;
+        telnet.greet = true;
+        telnet.txlen = 0;
+        tx_tail = tx_head;
+        connected = true;
+    }
+
+    if ( req )
+    {
+        return ( acia_telnet_rx( ( uint8_t * )req, oset ) );
+    }
+
+    // The connection rewound to the last segment, it must be resent as it was
+    //
+    if ( telnet.txlen && pos == telnet.tx_oset )
+    {
+        return ( web_resp_add_data( sock, telnet.tx, telnet.txlen ) );
+    }
+
+    if ( ts->rx_ack != ts->seq )
+    {
+        return ( 0 );
+    }
+
+    telnet.txlen = 0;
+
+    if ( telnet.greet )
+    {
+        memcpy( telnet.tx, options, sizeof( options ) );
+        telnet.txlen = sizeof( options );
+        telnet.greet = false;
+    }
+
+    head = tx_head;
+    __sync_synchronize();
+
+    while ( tx_tail != head && telnet.txlen < ACIA_SEGMENT_LEN - 1 )
+    {
+        uint8_t c = tx_ring[tx_tail % ACIA_RING_SIZE];
+
+        telnet.tx[telnet.txlen++] = c;
+
+        if ( c == TN_IAC )
+        {
+            telnet.tx[telnet.txlen++] = TN_IAC;
+        }
+
+        ++tx_tail;
+    }
+
+    if ( !telnet.txlen )
+    {
+        return ( 0 );
+    }
+
+    telnet.tx_oset = pos;
+
+    return ( web_resp_add_data( sock, telnet.tx, telnet.txlen ) );
+}
+
+// Listen on the telnet port, for a single client
+//
+bool acia_telnet_setup( void )
+{
+    int sock;
+    struct sockaddr_in addr;
+
+    sock = socket( AF_INET, SOCK_STREAM, 0 );
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons( TELPORT );
+
+    if ( sock < 0 ||
+        bind( sock, ( struct sockaddr * )&addr, sizeof( addr ) ) < 0 ||
+        listen( sock, 1 ) < 0 )
+    {
+        return ( false );
+    }
+
+    return ( tcp_port_handler( TELPORT, acia_telnet_handler ) );
+}
+
+// Detect the end of the telnet connection
+//
+void acia_telnet_poll( void )
+{
+    if ( telnet.sock >= 0 && net_sockets[telnet.sock].state != T_ESTABLISHED )
+    {
+        telnet.sock = -1;
+        connected = false;
+    }
+}
@@ -0,0 +1,54 @@
+/*
+ * 6551 ACIA emulation and telnet bridge for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef ACIA_H
+#define ACIA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 6551 registers, from the device base address
+//
+#define ACIA_DATA           0           // Read for received data, write to transmit
+#define ACIA_STATUS         1           // Write for a programmed reset
+#define ACIA_COMMAND        2
+#define ACIA_CONTROL        3
+#define ACIA_NUM_REGS       4
+
+#define ACIA_RDRF           0x08        // Status bits. Receive data register full
+#define ACIA_TDRE           0x10        // Transmit data register empty
+#define ACIA_DCD            0x20        // Data carrier detect, high with no telnet client
+
+#define ACIA_RESET_MASK     0xE0        // Command bits kept by a programmed reset
+
+#define ACIA_RING_SIZE      1024        // Must be a power of 2
+#define ACIA_SEGMENT_LEN    512         // Max transmitted data per TCP segment
+
+bool acia_enable( uint16_t base );
+void acia_disable( void );
+void acia_write( uint16_t base, int reg, uint8_t value );
+void acia_poll( uint16_t base );
+
+bool acia_telnet_setup( void );
+void acia_telnet_poll( void );
+
+#endif /* ACIA_H */
@@ -0,0 +1,115 @@
+/*
+ * Bank switched ROM window for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+#include "library.h"
+#include "bank.h"
+
+static inline volatile uint8_t *bank_byte( uint32_t address )
+{
+    return ( volatile uint8_t * )&mem_map[address];
+}
+
+// Check that the window can be mapped: in range, enabled and clear of the
+// registers
+//
+static bool bank_window_ok( uint16_t base, uint32_t window, uint32_t len )
+{
+    if ( window % LIBRARY_PAGE_SIZE || window + len > MEM_MAP_SIZE
+        || ( base < window + len && window < base + BANK_NUM_REGS ) )
+    {
+        return ( false );
+    }
+
+    for ( uint32_t i = 0; i < len; ++i )
+    {
+        if ( ( mem_map[window + i] & MEM_ATTR_CE_MASK ) != MEM_ATTR_ENABLED )
+        {
+            return ( false );
+        }
+    }
+
+    return ( true );
+}
+
+// Called from core 1 on each 6502 write to the registers. A select command
+// copies the pages and replaces the command with the status, so the 6502
+// sees it busy until the window is ready.
+//
+// The pages are copied by the CPU, straight from the XIP mapped flash. DMA
+// can't be used, because the data bytes are interleaved with the attribute
+// bytes, and DMA can't skip them. The attributes are preserved, so the
+// window is usually set as ROM
+//
+void bank_write( uint16_t base, int reg, uint8_t value )
+{
+    uint32_t page, window, len;
+    const uint8_t *src;
+    uint8_t status = BANK_DONE;
+
+    if ( reg != BANK_CMD )
+    {
+        return;
+    }
+
+    page = *bank_byte( base + BANK_PAGE );
+    window = *bank_byte( base + BANK_WINDOW ) << 8;
+
+    switch ( value )
+    {
+        case BANK_SELECT_4K:
+            len = LIBRARY_PAGE_SIZE;
+            break;
+
+        case BANK_SELECT_8K:
+            len = 2 * LIBRARY_PAGE_SIZE;
+            break;
+
+        default:
+            len = 0;
+            break;
+    }
+
+    if ( !len || page + len / LIBRARY_PAGE_SIZE > LIBRARY_ROM_PAGES || !bank_window_ok( base, window, len ) )
+    {
+        status = BANK_ERROR;
+    }
+    else
+    {
+        // Consecutive pages are contiguous in flash
+        //
+        src = library_page( page );
+
+        for ( uint32_t i = 0; i < len; ++i )
+        {
+            *bank_byte( window + i ) = src[i];
+        }
+    }
+
+    // The window must be in place before the 6502 sees the status
+    //
+    __sync_synchronize();
+    *bank_byte( base + BANK_CMD ) = status;
+}
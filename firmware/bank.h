@@ -0,0 +1,46 @@
+/*
+ * Bank switched ROM window for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef BANK_H
+#define BANK_H
+
+#include <stdint.h>
+
+// Bank registers, from the device base address. A select command copies
+// one or two consecutive library pages, starting at PAGE, into the window.
+// The window is 4 KB aligned and must be enabled memory, RAM or ROM, not
+// overlapping the registers
+//
+#define BANK_PAGE           0           // First library page
+#define BANK_WINDOW         1           // Window address, high byte. Multiple of $10
+#define BANK_CMD            2           // Write a command to start
+#define BANK_NUM_REGS       3
+
+#define BANK_SELECT_4K      0x81        // Commands. Map a 4 KB page
+#define BANK_SELECT_8K      0x82        // Map two pages
+
+#define BANK_DONE           0x00        // Status values, replace the command when done
+#define BANK_ERROR          0xFF        // Bad command, page or window
+
+void bank_write( uint16_t base, int reg, uint8_t value );
+
+#endif /* BANK_H */
@@ -0,0 +1,174 @@
+/*
+ * Block move accelerator for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+#include "blockmove.h"
+
+static inline volatile uint8_t *blockmove_byte( uint16_t address )
+{
+    return ( volatile uint8_t * )&mem_map[address];
+}
+
+static inline uint16_t blockmove_get_word( uint16_t base, int reg )
+{
+    return ( *blockmove_byte( base + reg ) | *blockmove_byte( base + reg + 1 ) << 8 );
+}
+
+static inline void blockmove_set_word( uint16_t base, int reg, uint16_t value )
+{
+    *blockmove_byte( base + reg ) = value & 0xFF;
+    *blockmove_byte( base + reg + 1 ) = value >> 8;
+}
+
+// Only write to addresses that the 6502 could write, so ROM, including
+// the card's own, is not modified
+//
+static inline bool blockmove_writeable( uint32_t address )
+{
+    return ( ( mem_map[address] & MEM_ATTR_MASK ) == ( MEM_ATTR_ENABLED | MEM_ATTR_WRITEABLE ) );
+}
+
+static void blockmove_copy( uint32_t src, uint32_t dst, uint32_t len )
+{
+    if ( dst <= src )
+    {
+        for ( uint32_t i = 0; i < len; ++i )
+        {
+            if ( blockmove_writeable( dst + i ) )
+            {
+                *blockmove_byte( dst + i ) = *blockmove_byte( src + i );
+            }
+        }
+    }
+    else
+    {
+        // Copy backwards, so overlapping blocks are moved like memmove() does
+        //
+        for ( uint32_t i = len; i-- > 0; )
+        {
+            if ( blockmove_writeable( dst + i ) )
+            {
+                *blockmove_byte( dst + i ) = *blockmove_byte( src + i );
+            }
+        }
+    }
+}
+
+static void blockmove_fill( uint8_t value, uint32_t dst, uint32_t len )
+{
+    for ( uint32_t i = 0; i < len; ++i )
+    {
+        if ( blockmove_writeable( dst + i ) )
+        {
+            *blockmove_byte( dst + i ) = value;
+        }
+    }
+}
+
+// Returns the offset of the first difference, or len if the blocks are equal
+//
+static uint32_t blockmove_compare( uint32_t src, uint32_t dst, uint32_t len )
+{
+    uint32_t i;
+
+    for ( i = 0; i < len; ++i )
+    {
+        if ( *blockmove_byte( src + i ) != *blockmove_byte( dst + i ) )
+        {
+            break;
+        }
+    }
+
+    return ( i );
+}
+
+// Called from core 1 on each 6502 write to the registers. Writing BLOCKMOVE_GO
+// to the status register runs the operation. The status keeps that value, so
+// the 6502 sees it busy, until the result is written.
+//
+// The operation runs on the memory map, with the CPU. DMA can't be used,
+// because the data bytes are interleaved with the attribute bytes, which
+// must be preserved and checked for each destination address
+//
+void blockmove_write( uint16_t base, int reg, uint8_t value )
+{
+    uint32_t src, dst, len, diff;
+    uint8_t status = BLOCKMOVE_DONE;
+
+    if ( reg != BLOCKMOVE_STATUS || value != BLOCKMOVE_GO )
+    {
+        return;
+    }
+
+    src = blockmove_get_word( base, BLOCKMOVE_SRC );
+    dst = blockmove_get_word( base, BLOCKMOVE_DST );
+    len = blockmove_get_word( base, BLOCKMOVE_LEN );
+
+    if ( dst + len > MEM_MAP_SIZE )
+    {
+        status = BLOCKMOVE_ERROR;
+    }
+    else
+    {
+        switch ( *blockmove_byte( base + BLOCKMOVE_MODE ) )
+        {
+            case BLOCKMOVE_COPY:
+                if ( src + len > MEM_MAP_SIZE )
+                {
+                    status = BLOCKMOVE_ERROR;
+                    break;
+                }
+                blockmove_copy( src, dst, len );
+                break;
+
+            case BLOCKMOVE_FILL:
+                blockmove_fill( src & 0xFF, dst, len );
+                break;
+
+            case BLOCKMOVE_COMPARE:
+                if ( src + len > MEM_MAP_SIZE )
+                {
+                    status = BLOCKMOVE_ERROR;
+                    break;
+                }
+                if ( ( diff = blockmove_compare( src, dst, len ) ) < len )
+                {
+                    blockmove_set_word( base, BLOCKMOVE_SRC, src + diff );
+                    blockmove_set_word( base, BLOCKMOVE_DST, dst + diff );
+                    status = BLOCKMOVE_MISMATCH;
+                }
+                break;
+
+            default:
+                status = BLOCKMOVE_ERROR;
+                break;
+        }
+    }
+
+    // The results must be in place before the 6502 sees the status
+    //
+    __sync_synchronize();
+    *blockmove_byte( base + BLOCKMOVE_STATUS ) = status;
+}
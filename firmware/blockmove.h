@@ -0,0 +1,49 @@
+/*
+ * Block move accelerator for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef BLOCKMOVE_H
+#define BLOCKMOVE_H
+
+#include <stdint.h>
+
+// Block move registers, from the device base address. Addresses and length
+// are little endian
+//
+#define BLOCKMOVE_SRC       0           // Source address, or fill value in the low byte
+#define BLOCKMOVE_DST       2           // Destination address
+#define BLOCKMOVE_LEN       4           // Byte count
+#define BLOCKMOVE_MODE      6
+#define BLOCKMOVE_STATUS    7           // Write BLOCKMOVE_GO to start
+#define BLOCKMOVE_NUM_REGS  8
+
+#define BLOCKMOVE_COPY      0           // Modes
+#define BLOCKMOVE_FILL      1
+#define BLOCKMOVE_COMPARE   2
+
+#define BLOCKMOVE_GO        0x80        // Status values. Reads as busy until done
+#define BLOCKMOVE_DONE      0x00
+#define BLOCKMOVE_MISMATCH  0x01        // SRC and DST point to the first difference
+#define BLOCKMOVE_ERROR     0xFF        // Bad mode or range past $FFFF
+
+void blockmove_write( uint16_t base, int reg, uint8_t value );
+
+#endif /* BLOCKMOVE_H */
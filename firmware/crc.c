@@ -0,0 +1,61 @@
+/*
+ * CRC calculation for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+
+#include "crc.h"
+
+static int crc_dma;
+
+void crc_setup( void )
+{
+    crc_dma = dma_claim_unused_channel( true );
+}
+
+// CRC-32 (IEEE 802.3, same as zlib) of a memory region. The data is copied by
+// DMA to a dummy destination and the sniffer calculates the CRC on the fly
+//
+uint32_t crc_calc( const void *data, uint32_t len )
+{
+    static uint8_t dummy;
+
+    dma_channel_config dma_config = dma_channel_get_default_config( crc_dma );
+
+    channel_config_set_transfer_data_size( &dma_config, DMA_SIZE_8 );
+    channel_config_set_read_increment( &dma_config, true );
+    channel_config_set_write_increment( &dma_config, false );
+    channel_config_set_sniff_enable( &dma_config, true );
+
+    // Bit reversed input and reversed and inverted output, as the standard CRC-32
+    //
+    dma_sniffer_enable( crc_dma, DMA_SNIFF_CTRL_CALC_VALUE_CRC32R, true );
+    dma_sniffer_set_output_reverse_enabled( true );
+    dma_sniffer_set_output_invert_enabled( true );
+    dma_hw->sniff_data = 0xFFFFFFFF;
+
+    dma_channel_configure( crc_dma, &dma_config, &dummy, data, len, true );
+    dma_channel_wait_for_finish_blocking( crc_dma );
+
+    return dma_hw->sniff_data;
+}
@@ -0,0 +1,228 @@
+/*
+ * Memory mapped devices for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "config.h"
+#include "mememul.h"
+#include "devices.h"
+#include "blockmove.h"
+#include "mathunit.h"
+#include "graphics.h"
+#include "acia.h"
+#include "bank.h"
+#include "programs.h"
+#include "stats.h"
+
+static const device_t devices[] = {
+    { .name = "blockmove",  .size = BLOCKMOVE_NUM_REGS, .write = blockmove_write },
+    { .name = "math",       .size = MATH_NUM_REGS,      .write = mathunit_write },
+    { .name = "graphics",   .size = GFX_NUM_REGS,       .write = graphics_write },
+    { .name = "acia",       .size = ACIA_NUM_REGS,      .enable = acia_enable, .disable = acia_disable,
+                                                        .write = acia_write, .poll = acia_poll },
+    { .name = "bank",       .size = BANK_NUM_REGS,      .write = bank_write },
+    { .name = "loader",     .size = LOADER_NUM_REGS,    .write = programs_write },
+};
+
+#define NUM_DEVICES ( sizeof( devices ) / sizeof( devices[0] ) )
+
+// Base address of each device, -1 if disabled. Set from core 0, read by core 1
+//
+static volatile int32_t device_base[NUM_DEVICES] = { [0 ... NUM_DEVICES - 1] = -1 };
+
+// Write tap cursor of the device loop. Its overruns are the times that core 1
+// fell behind the 6502 and device writes were lost
+//
+static mememul_tap_cursor_t tap_cursor;
+
+// Device loop, runs on core 1. Never returns
+//
+void devices_run( void )
+{
+    uint16_t address;
+    int32_t base;
+
+    mememul_tap_cursor( &tap_cursor );
+
+    while ( true )
+    {
+        while ( mememul_tap_next( &tap_cursor, &address ) )
+        {
+            for ( int i = 0; i < NUM_DEVICES; ++i )
+            {
+                base = device_base[i];
+
+                if ( base >= 0 && address >= base && address < base + devices[i].size )
+                {
+                    devices[i].write( base, address - base, mem_map[address] & MEM_DATA_MASK );
+                    break;
+                }
+            }
+        }
+
+        for ( int i = 0; i < NUM_DEVICES; ++i )
+        {
+            base = device_base[i];
+
+            if ( base >= 0 && devices[i].poll )
+            {
+                devices[i].poll( base );
+            }
+        }
+
+        // The page access counters follow the bus from here too
+        //
+        stats_poll();
+    }
+}
+
+// Times the device loop lost writes because the write tap wrapped
+//
+uint32_t devices_overruns( void )
+{
+    return ( tap_cursor.overruns );
+}
+
+int devices_find( const char *name )
+{
+    for ( int i = 0; i < NUM_DEVICES; ++i )
+    {
+        if ( strcmp( name, devices[i].name ) == 0 )
+        {
+            return ( i );
+        }
+    }
+
+    return ( -1 );
+}
+
+// Base address of the device, -1 if it is not mapped
+//
+int32_t devices_base( int device )
+{
+    return ( device_base[device] );
+}
+
+// Map the device registers at the given address. The block must be enabled
+// RAM, so the 6502 can read and write them, and must not overlap the block
+// of another device. The registers are cleared before the device enable
+// function, which can set them up
+//
+bool devices_enable( int device, uint16_t address )
+{
+    int size = devices[device].size;
+
+    if ( address + size > MEM_MAP_SIZE )
+    {
+        return ( false );
+    }
+
+    for ( int i = 0; i < NUM_DEVICES; ++i )
+    {
+        if ( i != device && device_base[i] >= 0
+            && address < device_base[i] + devices[i].size && device_base[i] < address + size )
+        {
+            return ( false );
+        }
+    }
+
+    for ( int i = 0; i < size; ++i )
+    {
+        if ( ( mem_map[address + i] & MEM_ATTR_MASK ) != ( MEM_ATTR_ENABLED | MEM_ATTR_WRITEABLE ) )
+        {
+            return ( false );
+        }
+    }
+
+    device_base[device] = -1;
+    __sync_synchronize();
+
+    if ( devices[device].disable )
+    {
+        devices[device].disable();
+    }
+
+    for ( int i = 0; i < size; ++i )
+    {
+        *( volatile uint8_t * )&mem_map[address + i] = 0;
+    }
+
+    if ( devices[device].enable && !devices[device].enable( address ) )
+    {
+        return ( false );
+    }
+
+    // The registers must be clear before core 1 sees the new base
+    //
+    __sync_synchronize();
+    device_base[device] = address;
+
+    return ( true );
+}
+
+// Unmap the device. Its registers are left as plain RAM
+//
+void devices_disable( int device )
+{
+    device_base[device] = -1;
+
+    if ( devices[device].disable )
+    {
+        devices[device].disable();
+    }
+}
+
+// Device list as JSON. Returns the length, or -1 if it does not fit
+//
+int devices_json( char *buf, int size )
+{
+    int n = 0;
+
+#define DEVICES_ADD( expr ) do { n += ( expr ); if ( n >= size ) return -1; } while ( 0 )
+#define DEVICES_PUT( ... ) DEVICES_ADD( snprintf( &buf[n], size - n, __VA_ARGS__ ) )
+
+    DEVICES_PUT( "[" );
+
+    for ( int i = 0; i < NUM_DEVICES; ++i )
+    {
+        int32_t base = device_base[i];
+
+        DEVICES_PUT( "%s{\"name\":\"%s\",\"size\":%d,\"enabled\":%s", i ? "," : "", devices[i].name,
+                     devices[i].size, base >= 0 ? "true" : "false" );
+
+        if ( base >= 0 )
+        {
+            DEVICES_PUT( ",\"address\":\"%04x\"", ( unsigned ) base );
+        }
+
+        DEVICES_PUT( "}" );
+    }
+
+    DEVICES_PUT( "]" );
+
+#undef DEVICES_PUT
+#undef DEVICES_ADD
+
+    return ( n );
+}
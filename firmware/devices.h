@@ -0,0 +1,58 @@
+/*
+ * Memory mapped devices for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef DEVICES_H
+#define DEVICES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Memory mapped devices are blocks of registers in the KIM-1 address space,
+// served from the memory map like any other RAM. Core 1 follows the 6502
+// writes from the write tap and calls the device for each write to one of
+// its registers, so it can act on it and leave the results in the registers.
+// Devices that have work of their own, like the ACIA, are also polled from
+// the core 1 loop.
+//
+typedef bool ( *device_enable_t )( uint16_t base );
+typedef void ( *device_disable_t )( void );
+typedef void ( *device_write_t )( uint16_t base, int reg, uint8_t value );
+typedef void ( *device_poll_t )( uint16_t base );
+
+typedef struct {
+    const char      *name;
+    int             size;               // Number of registers
+    device_enable_t enable;             // Optional, called from core 0 when mapped. Can refuse the address
+    device_disable_t disable;           // Optional, called from core 0 when unmapped
+    device_write_t  write;              // Called from core 1 after each 6502 write to a register
+    device_poll_t   poll;               // Optional, called from core 1 on every loop
+} device_t;
+
+void devices_run( void );
+uint32_t devices_overruns( void );
+int devices_find( const char *name );
+int32_t devices_base( int device );
+bool devices_enable( int device, uint16_t address );
+void devices_disable( int device );
+int devices_json( char *buf, int size );
+
+#endif /* DEVICES_H */
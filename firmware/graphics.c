@@ -0,0 +1,441 @@
+/*
+ * K-1008 graphics accelerator for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "video.h"
+#include "graphics.h"
+
+#define GFX_FIRST_CHAR      0x20
+
+// 8x8 font for the printable ASCII characters, most significant bit to the
+// left, as in the K-1008 memory
+//
+static const uint8_t font[][8] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // ' '
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x10, 0x00 },   // '!'
+    { 0x28, 0x28, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '"'
+    { 0x28, 0x28, 0x7c, 0x28, 0x7c, 0x28, 0x28, 0x00 },   // '#'
+    { 0x10, 0x3c, 0x50, 0x38, 0x14, 0x78, 0x10, 0x00 },   // '$'
+    { 0x60, 0x64, 0x08, 0x10, 0x20, 0x4c, 0x0c, 0x00 },   // '%'
+    { 0x30, 0x48, 0x50, 0x20, 0x54, 0x48, 0x34, 0x00 },   // '&'
+    { 0x10, 0x10, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '''
+    { 0x08, 0x10, 0x20, 0x20, 0x20, 0x10, 0x08, 0x00 },   // '('
+    { 0x20, 0x10, 0x08, 0x08, 0x08, 0x10, 0x20, 0x00 },   // ')'
+    { 0x00, 0x10, 0x54, 0x38, 0x54, 0x10, 0x00, 0x00 },   // '*'
+    { 0x00, 0x10, 0x10, 0x7c, 0x10, 0x10, 0x00, 0x00 },   // '+'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x10, 0x20 },   // ','
+    { 0x00, 0x00, 0x00, 0x7c, 0x00, 0x00, 0x00, 0x00 },   // '-'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x00 },   // '.'
+    { 0x00, 0x04, 0x08, 0x10, 0x20, 0x40, 0x00, 0x00 },   // '/'
+    { 0x38, 0x44, 0x4c, 0x54, 0x64, 0x44, 0x38, 0x00 },   // '0'
+    { 0x10, 0x30, 0x10, 0x10, 0x10, 0x10, 0x38, 0x00 },   // '1'
+    { 0x38, 0x44, 0x04, 0x08, 0x10, 0x20, 0x7c, 0x00 },   // '2'
+    { 0x7c, 0x08, 0x10, 0x08, 0x04, 0x44, 0x38, 0x00 },   // '3'
+    { 0x08, 0x18, 0x28, 0x48, 0x7c, 0x08, 0x08, 0x00 },   // '4'
+    { 0x7c, 0x40, 0x78, 0x04, 0x04, 0x44, 0x38, 0x00 },   // '5'
+    { 0x18, 0x20, 0x40, 0x78, 0x44, 0x44, 0x38, 0x00 },   // '6'
+    { 0x7c, 0x04, 0x08, 0x10, 0x20, 0x20, 0x20, 0x00 },   // '7'
+    { 0x38, 0x44, 0x44, 0x38, 0x44, 0x44, 0x38, 0x00 },   // '8'
+    { 0x38, 0x44, 0x44, 0x3c, 0x04, 0x08, 0x30, 0x00 },   // '9'
+    { 0x00, 0x30, 0x30, 0x00, 0x30, 0x30, 0x00, 0x00 },   // ':'
+    { 0x00, 0x30, 0x30, 0x00, 0x30, 0x10, 0x20, 0x00 },   // ';'
+    { 0x08, 0x10, 0x20, 0x40, 0x20, 0x10, 0x08, 0x00 },   // '<'
+    { 0x00, 0x00, 0x7c, 0x00, 0x7c, 0x00, 0x00, 0x00 },   // '='
+    { 0x20, 0x10, 0x08, 0x04, 0x08, 0x10, 0x20, 0x00 },   // '>'
+    { 0x38, 0x44, 0x04, 0x08, 0x10, 0x00, 0x10, 0x00 },   // '?'
+    { 0x38, 0x44, 0x04, 0x34, 0x54, 0x54, 0x38, 0x00 },   // '@'
+    { 0x38, 0x44, 0x44, 0x7c, 0x44, 0x44, 0x44, 0x00 },   // 'A'
+    { 0x78, 0x44, 0x44, 0x78, 0x44, 0x44, 0x78, 0x00 },   // 'B'
+    { 0x38, 0x44, 0x40, 0x40, 0x40, 0x44, 0x38, 0x00 },   // 'C'
+    { 0x70, 0x48, 0x44, 0x44, 0x44, 0x48, 0x70, 0x00 },   // 'D'
+    { 0x7c, 0x40, 0x40, 0x78, 0x40, 0x40, 0x7c, 0x00 },   // 'E'
+    { 0x7c, 0x40, 0x40, 0x78, 0x40, 0x40, 0x40, 0x00 },   // 'F'
+    { 0x38, 0x44, 0x40, 0x5c, 0x44, 0x44, 0x3c, 0x00 },   // 'G'
+    { 0x44, 0x44, 0x44, 0x7c, 0x44, 0x44, 0x44, 0x00 },   // 'H'
+    { 0x38, 0x10, 0x10, 0x10, 0x10, 0x10, 0x38, 0x00 },   // 'I'
+    { 0x1c, 0x08, 0x08, 0x08, 0x08, 0x48, 0x30, 0x00 },   // 'J'
+    { 0x44, 0x48, 0x50, 0x60, 0x50, 0x48, 0x44, 0x00 },   // 'K'
+    { 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x7c, 0x00 },   // 'L'
+    { 0x44, 0x6c, 0x54, 0x54, 0x44, 0x44, 0x44, 0x00 },   // 'M'
+    { 0x44, 0x44, 0x64, 0x54, 0x4c, 0x44, 0x44, 0x00 },   // 'N'
+    { 0x38, 0x44, 0x44, 0x44, 0x44, 0x44, 0x38, 0x00 },   // 'O'
+    { 0x78, 0x44, 0x44, 0x78, 0x40, 0x40, 0x40, 0x00 },   // 'P'
+    { 0x38, 0x44, 0x44, 0x44, 0x54, 0x48, 0x34, 0x00 },   // 'Q'
+    { 0x78, 0x44, 0x44, 0x78, 0x50, 0x48, 0x44, 0x00 },   // 'R'
+    { 0x3c, 0x40, 0x40, 0x38, 0x04, 0x04, 0x78, 0x00 },   // 'S'
+    { 0x7c, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00 },   // 'T'
+    { 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x38, 0x00 },   // 'U'
+    { 0x44, 0x44, 0x44, 0x44, 0x44, 0x28, 0x10, 0x00 },   // 'V'
+    { 0x44, 0x44, 0x44, 0x54, 0x54, 0x54, 0x28, 0x00 },   // 'W'
+    { 0x44, 0x44, 0x28, 0x10, 0x28, 0x44, 0x44, 0x00 },   // 'X'
+    { 0x44, 0x44, 0x44, 0x28, 0x10, 0x10, 0x10, 0x00 },   // 'Y'
+    { 0x7c, 0x04, 0x08, 0x10, 0x20, 0x40, 0x7c, 0x00 },   // 'Z'
+    { 0x38, 0x20, 0x20, 0x20, 0x20, 0x20, 0x38, 0x00 },   // '['
+    { 0x00, 0x40, 0x20, 0x10, 0x08, 0x04, 0x00, 0x00 },   // '\\'
+    { 0x38, 0x08, 0x08, 0x08, 0x08, 0x08, 0x38, 0x00 },   // ']'
+    { 0x10, 0x28, 0x44, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '^'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7c },   // '_'
+    { 0x20, 0x10, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '`'
+    { 0x00, 0x00, 0x38, 0x04, 0x3c, 0x44, 0x3c, 0x00 },   // 'a'
+    { 0x40, 0x40, 0x58, 0x64, 0x44, 0x44, 0x78, 0x00 },   // 'b'
+    { 0x00, 0x00, 0x38, 0x40, 0x40, 0x44, 0x38, 0x00 },   // 'c'
+    { 0x04, 0x04, 0x34, 0x4c, 0x44, 0x44, 0x3c, 0x00 },   // 'd'
+    { 0x00, 0x00, 0x38, 0x44, 0x7c, 0x40, 0x38, 0x00 },   // 'e'
+    { 0x18, 0x24, 0x20, 0x70, 0x20, 0x20, 0x20, 0x00 },   // 'f'
+    { 0x00, 0x00, 0x3c, 0x44, 0x44, 0x3c, 0x04, 0x38 },   // 'g'
+    { 0x40, 0x40, 0x58, 0x64, 0x44, 0x44, 0x44, 0x00 },   // 'h'
+    { 0x10, 0x00, 0x30, 0x10, 0x10, 0x10, 0x38, 0x00 },   // 'i'
+    { 0x08, 0x00, 0x18, 0x08, 0x08, 0x08, 0x48, 0x30 },   // 'j'
+    { 0x40, 0x40, 0x48, 0x50, 0x60, 0x50, 0x48, 0x00 },   // 'k'
+    { 0x30, 0x10, 0x10, 0x10, 0x10, 0x10, 0x38, 0x00 },   // 'l'
+    { 0x00, 0x00, 0x68, 0x54, 0x54, 0x44, 0x44, 0x00 },   // 'm'
+    { 0x00, 0x00, 0x58, 0x64, 0x44, 0x44, 0x44, 0x00 },   // 'n'
+    { 0x00, 0x00, 0x38, 0x44, 0x44, 0x44, 0x38, 0x00 },   // 'o'
+    { 0x00, 0x00, 0x78, 0x44, 0x44, 0x78, 0x40, 0x40 },   // 'p'
+    { 0x00, 0x00, 0x3c, 0x44, 0x44, 0x3c, 0x04, 0x04 },   // 'q'
+    { 0x00, 0x00, 0x58, 0x64, 0x40, 0x40, 0x40, 0x00 },   // 'r'
+    { 0x00, 0x00, 0x3c, 0x40, 0x38, 0x04, 0x78, 0x00 },   // 's'
+    { 0x20, 0x20, 0x70, 0x20, 0x20, 0x24, 0x18, 0x00 },   // 't'
+    { 0x00, 0x00, 0x44, 0x44, 0x44, 0x4c, 0x34, 0x00 },   // 'u'
+    { 0x00, 0x00, 0x44, 0x44, 0x44, 0x28, 0x10, 0x00 },   // 'v'
+    { 0x00, 0x00, 0x44, 0x44, 0x54, 0x54, 0x28, 0x00 },   // 'w'
+    { 0x00, 0x00, 0x44, 0x28, 0x10, 0x28, 0x44, 0x00 },   // 'x'
+    { 0x00, 0x00, 0x44, 0x44, 0x44, 0x3c, 0x04, 0x38 },   // 'y'
+    { 0x00, 0x00, 0x7c, 0x08, 0x10, 0x20, 0x7c, 0x00 },   // 'z'
+    { 0x08, 0x10, 0x10, 0x20, 0x10, 0x10, 0x08, 0x00 },   // '{'
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00 },   // '|'
+    { 0x20, 0x10, 0x10, 0x08, 0x10, 0x10, 0x20, 0x00 },   // '}'
+    { 0x00, 0x00, 0x20, 0x54, 0x08, 0x00, 0x00, 0x00 },   // '~'
+    { 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c },   // 0x7f
+};
+
+// Video memory start, read for each command as it can be moved from the web
+// server. Drawing ignores the memory attributes, like the video output does
+//
+static uint16_t video;
+
+static inline volatile uint8_t *gfx_reg( uint16_t address )
+{
+    return ( volatile uint8_t * )&mem_map[address];
+}
+
+static inline volatile uint8_t *gfx_byte( int x, int y )
+{
+    return gfx_reg( video + y * GFX_BYTES_PER_LINE + x / 8 );
+}
+
+static inline void gfx_apply( volatile uint8_t *byte, uint8_t mask, int mode )
+{
+    switch ( mode )
+    {
+        case GFX_CLEAR:
+            *byte &= ~mask;
+            break;
+
+        case GFX_SET:
+            *byte |= mask;
+            break;
+
+        default:
+            *byte ^= mask;
+            break;
+    }
+}
+
+static void gfx_plot( int x, int y, int mode )
+{
+    if ( x >= 0 && x < GFX_WIDTH && y >= 0 && y < GFX_HEIGHT )
+    {
+        gfx_apply( gfx_byte( x, y ), 0x80 >> ( x & 7 ), mode );
+    }
+}
+
+// Bits of the byte at x that are between x0 and x1
+//
+static inline uint8_t gfx_mask( int x, int x0, int x1 )
+{
+    uint8_t mask = 0xFF;
+
+    if ( x / 8 == x0 / 8 )
+    {
+        mask &= 0xFF >> ( x0 & 7 );
+    }
+    if ( x / 8 == x1 / 8 )
+    {
+        mask &= 0xFF << ( 7 - ( x1 & 7 ) );
+    }
+
+    return ( mask );
+}
+
+// Horizontal span from x0 to x1, both inside the screen, a byte at a time
+//
+static void gfx_span( int x0, int x1, int y, int mode )
+{
+    for ( int x = x0 & ~7; x <= x1; x += 8 )
+    {
+        gfx_apply( gfx_byte( x, y ), gfx_mask( x, x0, x1 ), mode );
+    }
+}
+
+static void gfx_copy_span( int x0, int x1, int from, int to )
+{
+    for ( int x = x0 & ~7; x <= x1; x += 8 )
+    {
+        uint8_t mask = gfx_mask( x, x0, x1 );
+
+        *gfx_byte( x, to ) = ( *gfx_byte( x, to ) & ~mask ) | ( *gfx_byte( x, from ) & mask );
+    }
+}
+
+static void gfx_line( int x0, int y0, int x1, int y1, int mode )
+{
+    int dx = abs( x1 - x0 ), sx = x0 < x1 ? 1 : -1;
+    int dy = -abs( y1 - y0 ), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy, e2;
+
+    while ( true )
+    {
+        gfx_plot( x0, y0, mode );
+
+        if ( x0 == x1 && y0 == y1 )
+        {
+            break;
+        }
+
+        e2 = 2 * err;
+
+        if ( e2 >= dy )
+        {
+            err += dy;
+            x0 += sx;
+        }
+        if ( e2 <= dx )
+        {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+// Order the corners of a rectangle and clip it to the screen. Returns false
+// if it is outside
+//
+static bool gfx_clip( int *x0, int *y0, int *x1, int *y1 )
+{
+    int t;
+
+    if ( *x0 > *x1 )
+    {
+        t = *x0; *x0 = *x1; *x1 = t;
+    }
+    if ( *y0 > *y1 )
+    {
+        t = *y0; *y0 = *y1; *y1 = t;
+    }
+    if ( *x0 >= GFX_WIDTH || *y0 >= GFX_HEIGHT )
+    {
+        return ( false );
+    }
+    if ( *x1 >= GFX_WIDTH )
+    {
+        *x1 = GFX_WIDTH - 1;
+    }
+    if ( *y1 >= GFX_HEIGHT )
+    {
+        *y1 = GFX_HEIGHT - 1;
+    }
+
+    return ( true );
+}
+
+static void gfx_rect( int x0, int y0, int x1, int y1, int mode )
+{
+    if ( gfx_clip( &x0, &y0, &x1, &y1 ) )
+    {
+        for ( int y = y0; y <= y1; ++y )
+        {
+            gfx_span( x0, x1, y, mode );
+        }
+    }
+}
+
+// Sprite rows are ( width + 7 ) / 8 bytes, most significant bit to the left
+//
+static void gfx_blit( int x, int y, int width, int height, uint16_t address )
+{
+    int row_len = ( width + 7 ) / 8;
+
+    for ( int row = 0; row < height; ++row )
+    {
+        for ( int col = 0; col < width; ++col )
+        {
+            if ( *gfx_reg( address + row * row_len + col / 8 ) & ( 0x80 >> ( col & 7 ) ) )
+            {
+                gfx_plot( x + col, y + row, GFX_XOR );
+            }
+        }
+    }
+}
+
+// Scroll the region up by rows, or down if negative. Vacated rows are cleared
+//
+static void gfx_scroll( int x0, int y0, int x1, int y1, int rows )
+{
+    if ( !gfx_clip( &x0, &y0, &x1, &y1 ) )
+    {
+        return;
+    }
+
+    if ( rows > 0 )
+    {
+        for ( int y = y0; y <= y1; ++y )
+        {
+            if ( y + rows <= y1 )
+            {
+                gfx_copy_span( x0, x1, y + rows, y );
+            }
+            else
+            {
+                gfx_span( x0, x1, y, GFX_CLEAR );
+            }
+        }
+    }
+    else if ( rows < 0 )
+    {
+        for ( int y = y1; y >= y0; --y )
+        {
+            if ( y + rows >= y0 )
+            {
+                gfx_copy_span( x0, x1, y + rows, y );
+            }
+            else
+            {
+                gfx_span( x0, x1, y, GFX_CLEAR );
+            }
+        }
+    }
+}
+
+// The whole 8x8 cell is drawn. GFX_SET draws the glyph over a clear
+// background and GFX_CLEAR draws it inverted. GFX_XOR only flips the pixels
+// of the glyph
+//
+static void gfx_char( int x, int y, const uint8_t *glyph, int mode )
+{
+    for ( int row = 0; row < 8; ++row )
+    {
+        for ( int col = 0; col < 8; ++col )
+        {
+            bool on = glyph[row] & ( 0x80 >> col );
+
+            if ( mode == GFX_XOR )
+            {
+                if ( on )
+                {
+                    gfx_plot( x + col, y + row, GFX_XOR );
+                }
+            }
+            else
+            {
+                gfx_plot( x + col, y + row, on == ( mode == GFX_SET ) ? GFX_SET : GFX_CLEAR );
+            }
+        }
+    }
+}
+
+// Called from core 1 on each 6502 write to the registers. Writing a command
+// to the command register runs it. The register keeps the command, with bit 7
+// set, so the 6502 sees it busy, until it is replaced by the status. The
+// video output reads the memory map, so the result is shown on the next frame
+//
+void graphics_write( uint16_t base, int reg, uint8_t value )
+{
+    int x0, y0, x1, y1, mode;
+    uint8_t arg, status = GFX_DONE;
+
+    if ( reg != GFX_CMD )
+    {
+        return;
+    }
+
+    x0 = *gfx_reg( base + GFX_X ) | *gfx_reg( base + GFX_X + 1 ) << 8;
+    y0 = *gfx_reg( base + GFX_Y );
+    x1 = *gfx_reg( base + GFX_X2 ) | *gfx_reg( base + GFX_X2 + 1 ) << 8;
+    y1 = *gfx_reg( base + GFX_Y2 );
+    mode = *gfx_reg( base + GFX_MODE );
+    arg = *gfx_reg( base + GFX_ARG );
+
+    video = video_get_mem_start();
+
+    if ( mode > GFX_XOR )
+    {
+        status = GFX_ERROR;
+    }
+    else
+    {
+        switch ( value )
+        {
+            case GFX_PLOT:
+                gfx_plot( x0, y0, mode );
+                break;
+
+            case GFX_LINE:
+                gfx_line( x0, y0, x1, y1, mode );
+                break;
+
+            case GFX_RECT:
+                gfx_rect( x0, y0, x1, y1, mode );
+                break;
+
+            case GFX_BLIT:
+                gfx_blit( x0, y0, x1, y1, *gfx_reg( base + GFX_ADDR ) | *gfx_reg( base + GFX_ADDR + 1 ) << 8 );
+                break;
+
+            case GFX_SCROLL:
+                gfx_scroll( x0, y0, x1, y1, ( int8_t ) arg );
+                break;
+
+            case GFX_CHAR:
+                if ( arg < GFX_FIRST_CHAR || arg >= GFX_FIRST_CHAR + sizeof( font ) / sizeof( font[0] ) )
+                {
+                    status = GFX_ERROR;
+                    break;
+                }
+                gfx_char( x0, y0, font[arg - GFX_FIRST_CHAR], mode );
+                break;
+
+            default:
+                status = GFX_ERROR;
+                break;
+        }
+    }
+
+    // The drawing must be done before the 6502 sees the status
+    //
+    __sync_synchronize();
+    *gfx_reg( base + GFX_CMD ) = status;
+}
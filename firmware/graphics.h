@@ -0,0 +1,62 @@
+/*
+ * K-1008 graphics accelerator for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef GRAPHICS_H
+#define GRAPHICS_H
+
+#include <stdint.h>
+
+// Graphics registers, from the device base address. Coordinates are in
+// pixels, with 0,0 at the top left corner. X coordinates and the address
+// are little endian
+//
+#define GFX_X               0           // Start point, top left corner
+#define GFX_Y               2
+#define GFX_X2              3           // End point, bottom right corner, or sprite width
+#define GFX_Y2              5           //   and height
+#define GFX_ADDR            6           // Sprite address
+#define GFX_MODE            8
+#define GFX_ARG             9           // Character, or rows to scroll up (negative, down)
+#define GFX_CMD             10          // Write a command to start
+#define GFX_NUM_REGS        11
+
+#define GFX_PLOT            0x80        // Commands. Plot a pixel at X,Y
+#define GFX_LINE            0x81        // Line from X,Y to X2,Y2
+#define GFX_RECT            0x82        // Filled rectangle, from X,Y to X2,Y2
+#define GFX_BLIT            0x83        // XOR an X2 by Y2 sprite from ADDR at X,Y
+#define GFX_SCROLL          0x84        // Scroll the X,Y to X2,Y2 region ARG rows
+#define GFX_CHAR            0x85        // Draw the 8x8 glyph of character ARG at X,Y
+
+#define GFX_CLEAR           0           // Drawing modes
+#define GFX_SET             1
+#define GFX_XOR             2
+
+#define GFX_DONE            0x00        // Status values, replace the command when done
+#define GFX_ERROR           0xFF        // Unknown command, mode or character
+
+#define GFX_WIDTH           320
+#define GFX_HEIGHT          200
+#define GFX_BYTES_PER_LINE  ( GFX_WIDTH / 8 )
+
+void graphics_write( uint16_t base, int reg, uint8_t value );
+
+#endif /* GRAPHICS_H */
@@ -0,0 +1,212 @@
+/*
+ * Hardware replacements for the host build of the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+
+#include "config.h"
+#include "video.h"
+#include "crc.h"
+#include "mememul.h"
+#include "library.h"
+
+// On the Pico, these are placed by the linker script
+//
+uint16_t mem_map[MEM_MAP_SIZE];
+config_t config;
+
+uint32_t time_us_32( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( uint32_t )( ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000 );
+}
+
+void sleep_ms( uint32_t ms )
+{
+    struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = ( ms % 1000 ) * 1000000L };
+
+    nanosleep( &ts, NULL );
+}
+
+static uint16_t video_mem_start;
+
+void video_setup( uint16_t *mem_map )
+{
+    video_mem_start = config.video.k1008;
+}
+
+void video_set_mem_start( uint16_t mem_start )
+{
+    video_mem_start = mem_start;
+    printf( "Video memory start set to 0x%04X\n", mem_start );
+}
+
+uint16_t video_get_mem_start( void )
+{
+    return ( video_mem_start );
+}
+
+// There is no 6502 bus, so the write tap never logs anything
+//
+void mememul_tap_cursor( mememul_tap_cursor_t *cursor )
+{
+    cursor->index = cursor->stamp = 0;
+}
+
+bool mememul_tap_next( mememul_tap_cursor_t *cursor, uint16_t *address )
+{
+    return false;
+}
+
+// Nor a bus to monitor
+//
+void mememul_busmon_start( uint16_t address )
+{
+}
+
+void mememul_busmon_stop( void )
+{
+}
+
+bool mememul_busmon_next( int *reg, bool *read )
+{
+    return false;
+}
+
+// The ROM library is kept in memory, so it does not survive a restart. Like
+// erased flash, it reads as $FF until written
+//
+static uint8_t library[LIBRARY_NUM_PAGES * LIBRARY_PAGE_SIZE];
+static bool library_blank = true;
+
+const uint8_t *library_page( int page )
+{
+    if ( library_blank )
+    {
+        memset( library, 0xFF, sizeof( library ) );
+        library_blank = false;
+    }
+
+    return ( &library[page * LIBRARY_PAGE_SIZE] );
+}
+
+bool library_erase( int page )
+{
+    if ( page < 0 || page >= LIBRARY_NUM_PAGES )
+    {
+        return ( false );
+    }
+
+    memset( ( uint8_t * )library_page( page ), 0xFF, LIBRARY_PAGE_SIZE );
+
+    return ( true );
+}
+
+// Programming can only clear bits, as in the flash
+//
+bool library_program( int page, uint32_t offset, const uint8_t *data, uint32_t len )
+{
+    uint8_t *dst;
+
+    if ( page < 0 || page >= LIBRARY_NUM_PAGES || offset + len > LIBRARY_PAGE_SIZE
+        || offset % LIBRARY_CHUNK_SIZE || len % LIBRARY_CHUNK_SIZE )
+    {
+        return ( false );
+    }
+
+    dst = ( uint8_t * )library_page( page ) + offset;
+
+    for ( uint32_t i = 0; i < len; ++i )
+    {
+        dst[i] &= data[i];
+    }
+
+    return ( true );
+}
+
+// Nor cycles to count
+//
+uint32_t mememul_pagemon_count( void )
+{
+    return 0;
+}
+
+bool mememul_pagemon_next( uint32_t *cursor, uint16_t *address, uint8_t *data, bool *card, bool *read )
+{
+    return false;
+}
+
+// Nor a bus clock to sample
+//
+bool mememul_bus_address( uint16_t *address )
+{
+    return false;
+}
+
+void crc_setup( void )
+{
+}
+
+// Bitwise CRC-32, same as the DMA sniffer on the Pico
+//
+uint32_t crc_calc( const void *data, uint32_t len )
+{
+    const uint8_t *p = data;
+    uint32_t crc = 0xFFFFFFFF;
+
+    while ( len-- )
+    {
+        crc ^= *p++;
+
+        for ( int bit = 0; bit < 8; ++bit )
+        {
+            crc = ( crc >> 1 ) ^ ( 0xEDB88320 & -( crc & 1 ) );
+        }
+    }
+
+    return ~crc;
+}
+
+char *strnstr( const char *s, const char *find, size_t slen )
+{
+    size_t len = strlen( find );
+
+    if ( !len )
+    {
+        return ( char * )s;
+    }
+
+    for ( ; slen >= len && *s; ++s, --slen )
+    {
+        if ( *s == *find && !strncmp( s, find, len ) )
+        {
+            return ( char * )s;
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,221 @@
+/*
+ * TAP based network layer for the host build of the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ *
+ *  Replaces the CYW43439 event layer of the PicoWi library, derived from code
+ *  of the PicoWi library, original copyrigth follows
+ */
+
+// Copyright (c) 2022, Jeremy P Bentham
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "picowi.h"
+#include "picowi_udp.h"
+#include "tap.h"
+
+#define MAX_HANDLERS    20
+#define TAP_WAIT_MSEC   1           // Max time to block waiting for a frame
+
+int num_handlers;
+event_handler_t event_handlers[MAX_HANDLERS];
+WORD event_ports[MAX_HANDLERS];
+
+uint8_t rxdata[RXDATA_LEN];
+EVENT_INFO event_info;
+
+int display_mode;
+MACADDR my_mac = { 0x02, 0x00, 0x00, 0x4B, 0x49, 0x4D };
+IPADDR router_ip;
+int dhcp_complete = 2;              // Static address, no DHCP
+
+// Set display mode
+void set_display_mode(int mask)
+{
+    display_mode = mask;
+}
+
+// Display diagnostic data
+void display(int mask, const char* fmt, ...)
+{
+    va_list args;
+
+    if (display_mode & mask)
+    {
+        va_start(args, fmt);
+        vprintf(fmt, args);
+        va_end(args);
+    }
+}
+
+// Add an event handler to the chain
+bool add_event_handler(event_handler_t fn)
+{
+    return(add_server_event_handler(fn , 0));
+}
+
+// Add a server event handler to the chain (with local port number)
+bool add_server_event_handler(event_handler_t fn, WORD port)
+{
+    bool ok = num_handlers < MAX_HANDLERS;
+    if (ok)
+    {
+        event_ports[num_handlers] = port;
+        event_handlers[num_handlers++] = fn;
+    }
+    return (ok);
+}
+
+// Run event handlers, until one returns non-zero
+int event_handle(EVENT_INFO *eip)
+{
+    int i, ret=0;
+    
+    for (i=0; i<num_handlers && !ret; i++)
+    {
+        eip->server_port = event_ports[i];
+        ret = event_handlers[i](eip);
+    }
+    return(ret);
+}
+
+// Poll for an incoming frame on the TAP interface, pass it to the handlers
+int event_poll(void)
+{
+    EVENT_INFO *eip = &event_info;
+    int n;
+
+    if ((n = tap_read(rxdata, sizeof(rxdata))) <= 0)
+        return (0);
+    memset(eip, 0, sizeof(EVENT_INFO));
+    eip->chan = SDPCM_CHAN_DATA;
+    eip->data = rxdata;
+    eip->dlen = n;
+    eip->sock = -1;
+    display(DISP_EVENT, "Rx_DATA len %d\n", n);
+    return (event_handle(eip));
+}
+
+// Transmit network data
+int event_net_tx(void *data, int len)
+{
+    display(DISP_DATA, "Tx_DATA len %d\n", len);
+    return (tap_write(data, len));
+}
+
+// Block for a short time waiting for a frame, so the main loop does not spin
+bool wifi_get_irq(void)
+{
+    return (tap_wait(TAP_WAIT_MSEC));
+}
+
+// The TAP interface is always up
+int link_check(void)
+{
+    return (1);
+}
+
+// There is no WiFi chip, DHCP or network join on the host. net_init() and
+// net_join() are replaced by host_net_init()
+int wifi_setup(void)
+{
+    return (0);
+}
+
+bool wifi_init(void)
+{
+    return (false);
+}
+
+bool join_start(uint32_t country, char *ssid, char *passwd)
+{
+    return (false);
+}
+
+int join_event_handler(EVENT_INFO *eip)
+{
+    return (0);
+}
+
+void join_state_poll(char *ssid, char *passwd)
+{
+}
+
+int dhcp_event_handler(EVENT_INFO *eip)
+{
+    return (0);
+}
+
+void dhcp_poll(void)
+{
+}
+
+uint32_t ustime(void)
+{
+    return (time_us_32());
+}
+
+// Return non-zero if timeout
+int ustimeout(uint32_t *tickp, int usec)
+{
+    uint32_t t = time_us_32();
+    uint32_t dt=t - *tickp;
+
+    if (usec == 0 || dt >= usec)
+    {
+        *tickp = t;
+        return (1);
+    }
+    return (0);
+}
+
+// Initialise the network stack on the TAP interface, with a static address
+int host_net_init(const char *ifname, IPADDR addr)
+{
+    if (tap_open(ifname) < 0)
+        return (0);
+    add_event_handler(arp_event_handler);
+    add_event_handler(icmp_event_handler);
+    add_event_handler(udp_event_handler);
+    return (ip_init(addr));
+}
+
+// EOF
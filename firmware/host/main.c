@@ -0,0 +1,151 @@
+/*
+ * Linux host build of the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include "pico/stdlib.h"
+
+#include "picowi.h"
+#include "config.h"
+#include "webserver.h"
+
+#define DEFAULT_IFNAME  "tap0"
+#define DEFAULT_ADDRESS "192.168.7.2"
+
+int host_net_init( const char *ifname, IPADDR addr );
+
+static void usage( const char *name )
+{
+    fprintf( stderr, "Usage: %s [-i ifname] [-a address] [-m memmap.bin] [-d display_mask]\n", name );
+    fprintf( stderr, "  -i  TAP interface name (default " DEFAULT_IFNAME ")\n" );
+    fprintf( stderr, "  -a  IP address of the emulated card (default " DEFAULT_ADDRESS ")\n" );
+    fprintf( stderr, "  -m  Default memory map, raw 16-bit words as returned by GET /ramrom/range\n" );
+    fprintf( stderr, "  -d  PicoWi display mask, in hex\n" );
+}
+
+static int load_memory_map( const char *file )
+{
+    FILE *fp = fopen( file, "rb" );
+    size_t n;
+
+    if ( NULL == fp )
+    {
+        perror( file );
+        return -1;
+    }
+
+    n = fread( config.memory, sizeof( uint16_t ), MEM_MAP_SIZE, fp );
+    fclose( fp );
+
+    if ( n != MEM_MAP_SIZE )
+    {
+        fprintf( stderr, "%s: short memory map, expected %d bytes\n", file, MEM_MAP_SIZE * 2 );
+        return -1;
+    }
+
+    return 0;
+}
+
+int main( int argc, char **argv )
+{
+    const char *ifname = DEFAULT_IFNAME;
+    const char *address = DEFAULT_ADDRESS;
+    const char *memfile = NULL;
+    int display = DISP_INFO | DISP_TCP_STATE;
+    unsigned int a[4];
+    IPADDR addr;
+    int opt;
+
+    while ( ( opt = getopt( argc, argv, "i:a:m:d:h" ) ) != -1 )
+    {
+        switch ( opt )
+        {
+            case 'i':
+                ifname = optarg;
+                break;
+
+            case 'a':
+                address = optarg;
+                break;
+
+            case 'm':
+                memfile = optarg;
+                break;
+
+            case 'd':
+                display = strtol( optarg, NULL, 16 );
+                break;
+
+            default:
+                usage( argv[0] );
+                return EXIT_FAILURE;
+        }
+    }
+
+    if ( sscanf( address, "%u.%u.%u.%u", &a[0], &a[1], &a[2], &a[3] ) != 4
+        || a[0] > 255 || a[1] > 255 || a[2] > 255 || a[3] > 255 )
+    {
+        fprintf( stderr, "Invalid address: %s\n", address );
+        return EXIT_FAILURE;
+    }
+
+    for ( int i = 0; i < 4; ++i )
+    {
+        addr[i] = ( BYTE )a[i];
+    }
+
+    // Without a memory map, the whole address space is enabled RAM
+    //
+    if ( memfile )
+    {
+        if ( load_memory_map( memfile ) )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    else
+    {
+        for ( int i = 0; i < MEM_MAP_SIZE; ++i )
+        {
+            config.memory[i] = MEM_ATTR_ENABLED | MEM_ATTR_WRITEABLE;
+        }
+    }
+
+    config_copy_default_memory_map( &mem_map[0] );
+
+    set_display_mode( display );
+
+    if ( !host_net_init( ifname, addr ) )
+    {
+        fprintf( stderr, "Can't open TAP interface %s\n", ifname );
+        return EXIT_FAILURE;
+    }
+
+    printf( "Emulated card at %s on %s\n", address, ifname );
+
+    // Never returns, unless there is an error
+    //
+    webserver_run();
+
+    return EXIT_FAILURE;
+}
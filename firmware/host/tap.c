@@ -0,0 +1,112 @@
+/*
+ * TAP interface for the host build of the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+// This file must not include the picowi headers, as they redefine the
+// BSD socket API
+//
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+#include "tap.h"
+
+static int tap_fd = -1;
+
+// Attach to an existing TAP interface (or create it, if we have the privileges)
+// The interface must be configured and up before any traffic can flow:
+//
+//   ip tuntap add dev tap0 mode tap user $USER
+//   ip addr add 192.168.7.1/24 dev tap0
+//   ip link set tap0 up
+//
+int tap_open( const char *ifname )
+{
+    struct ifreq ifr;
+
+    if ( ( tap_fd = open( "/dev/net/tun", O_RDWR | O_NONBLOCK ) ) < 0 )
+    {
+        perror( "open /dev/net/tun" );
+        return -1;
+    }
+
+    memset( &ifr, 0, sizeof( ifr ) );
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy( ifr.ifr_name, ifname, IFNAMSIZ - 1 );
+
+    if ( ioctl( tap_fd, TUNSETIFF, &ifr ) < 0 )
+    {
+        perror( "TUNSETIFF" );
+        close( tap_fd );
+        tap_fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+// Wait up to timeout_ms for a frame. Returns non-zero if there is one available
+//
+int tap_wait( int timeout_ms )
+{
+    struct pollfd pfd = { .fd = tap_fd, .events = POLLIN };
+
+    return ( poll( &pfd, 1, timeout_ms ) > 0 && ( pfd.revents & POLLIN ) );
+}
+
+// Read a frame, if available. Returns the frame length or 0 if none
+//
+int tap_read( uint8_t *buf, int len )
+{
+    ssize_t n = read( tap_fd, buf, len );
+
+    if ( n < 0 )
+    {
+        if ( errno != EAGAIN && errno != EWOULDBLOCK )
+        {
+            perror( "tap read" );
+        }
+        return 0;
+    }
+
+    return ( int )n;
+}
+
+// Write a frame. Returns the number of bytes written, 0 on error
+//
+int tap_write( const uint8_t *buf, int len )
+{
+    ssize_t n = write( tap_fd, buf, len );
+
+    if ( n < 0 )
+    {
+        perror( "tap write" );
+        return 0;
+    }
+
+    return ( int )n;
+}
@@ -19,8 +19,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
  * MA  02110-1301, USA.
  * 
- * httpd_extract_uri_parameters() and httpd_extract_headers() are
- * derived from code in the lwIP TCP/IP stack, original copyright below
+ * httpd_extract_uri_parameters() is derived from code in the lwIP
+ * TCP/IP stack, original copyright below
  */
 
 #include <string.h> /* strchr */
@@ -29,42 +29,45 @@
 #include "picowi.h"
 #include "httpd.h"
 
+// The request line and headers have already been parsed by web_page_rx(), which
+// passes the body data of the first segment to the handler
+//
 int httpd_init_http_request( http_request_t *http_req, NET_SOCKET *ts, char *req, int len )
 {
-  http_req->seq = ts->seq;
-  http_req->recvd = 0;
+  WEB_REQUEST *wr = &web_requests[ts - net_sockets];
 
-  /* Find beginning of headers */
-  http_req->headp = strnstr( req, "\r\n", len );
-  if ( NULL == http_req->headp )
+  if ( wr->state != WEB_PARSE_DONE )
   {
     return -1;
   }
-  http_req->headp += 2;
 
-  /* Find beginning of data */
-  http_req->bodyp = strnstr( http_req->headp, "\r\n\r\n", len );
-  if ( NULL == http_req->bodyp )
+  http_req->seq = ts->seq;
+  http_req->recvd = 0;
+  http_req->content_len = wr->content_len;
+  http_req->bodyp = ( uint8_t * )req;
+  http_req->paramcount = 0;
+
+  httpd_extract_uri_parameters( http_req, wr->uri );
+
+  for ( int i = 0; i < WEB_NUM_HEADERS; ++i )
   {
-    return -1;
+    http_req->headers[i] = wr->headers[i][0] ? wr->headers[i] : NULL;
   }
-  *http_req->bodyp = '\0';
-  http_req->bodyp += 4;
-
-  httpd_extract_uri_parameters( http_req, req );
-  httpd_extract_headers( http_req, http_req->headp );
 
-  for ( int i= 0; i < http_req->headercount; ++i )
+  for ( int i = 0; i < MAX_WEB_PATH_PARAMS; ++i )
   {
-    if ( strcmp( "Content-Length", http_req->headers[i] ) == 0 )
-    {
-      http_req->content_len = http_req->header_vals[i] ? atoi( http_req->header_vals[i] ) : 0;
-    }
+    http_req->path_params[i] = wr->params[i][0] ? wr->params[i] : NULL;
   }
 
   return 0;
 }
 
+/* Value of a request header, or NULL if not present */
+char *httpd_get_header( http_request_t *http_req, web_header_t header )
+{
+  return http_req->headers[header];
+}
+
 /*
  * Copyright (c) 2001-2003 Swedish Institute of Computer Science.
  * All rights reserved.
@@ -167,57 +170,3 @@ int httpd_extract_uri_parameters(http_request_t *http_req, char *req)
 
   return loop;
 }
-
-/**
- * Extract headers from the HTTP request
- *
- * @param http_req pointer to the http request structure
- * @param hd pointer to the beginning of the headers
- * @return number of headers extracted
- */
-int httpd_extract_headers( http_request_t *http_req, char *hd )
-{
-  int loop;
-  char *pair;
-  char *equals;
-
-  /* Pointer to the first header */
-  pair = hd;
-
-/* Parse up to HTTPD_MAX_HEADERS from the passed string and ignore the
-   * remainder (if any) */
-  for (loop = 0; (loop < HTTPD_MAX_HEADERS) && pair; loop++) {
-
-    /* Save the name of the parameter */
-    http_req->headers[loop] = pair;
-
-    /* Remember the start of this name: value pair */
-    equals = pair;
-
-    /* Find the start of the next name: value pair and replace the delimiter
-     * with a 0 to terminate the previous pair string. */
-    pair = strchr(pair, '\r');
-    if (pair) {
-      *pair = '\0';
-      pair += 2;
-    } else {
-      /* We didn't find a new parameter so find the last header */
-      /* Revert to NULL so that we exit the loop as expected. */
-      pair = NULL;
-    }
-
-    /* Now find the ": "" in the previous pair, replace it with '\0' and save
-     * the parameter value string. */
-    equals = strchr(equals, ':');
-    if (equals) {
-      *equals = '\0';
-      http_req->header_vals[loop] = equals + 2;
-    } else {
-      http_req->header_vals[loop] = NULL;
-    }
-  }
-
-  http_req->headercount = loop;
-
-  return loop;
-}
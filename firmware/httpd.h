@@ -19,8 +19,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
  * MA  02110-1301, USA.
  * 
- * httpd_extract_uri_parameters() and httpd_extract_headers() are
- * derived from code in the lwIP TCP/IP stack, original copyright below
+ * httpd_extract_uri_parameters() is derived from code in the lwIP
+ * TCP/IP stack, original copyright below
  */
 
 #ifndef HTTPD_H
@@ -30,18 +30,15 @@
 #include "picowi.h"
 
 #define HTTPD_MAX_GET_PARAMETERS 16
-#define HTTPD_MAX_HEADERS 16
 
 typedef struct http_request_s {
-    char *headp;                                /* Pointer to first header */
     uint8_t *bodyp;                             /* Pointer to the request body */
     uint16_t paramcount;
     char *params[HTTPD_MAX_GET_PARAMETERS];     /* Params extracted from the request URI */
     char *param_vals[HTTPD_MAX_GET_PARAMETERS]; /* Values for each extracted param */
 
-    uint16_t headercount;
-    char *headers[HTTPD_MAX_HEADERS];           /* Params extracted from the request */
-    char *header_vals[HTTPD_MAX_HEADERS];       /* Values for each extracted header */
+    char *headers[WEB_NUM_HEADERS];             /* Values of the headers kept by the parser, NULL if absent */
+    char *path_params[MAX_WEB_PATH_PARAMS];     /* Values of the {name} segments of the route */
 
     uint32_t hlen;                              /* Response headers length */
 
@@ -53,6 +50,6 @@ typedef struct http_request_s {
 
 int httpd_init_http_request( http_request_t *http_req, NET_SOCKET *ts, char *req, int len );
 int httpd_extract_uri_parameters( http_request_t *http_req, char *req );
-int httpd_extract_headers( http_request_t *http_req, char *hd );
+char *httpd_get_header( http_request_t *http_req, web_header_t header );
 
 #endif /* HTTPD_H */
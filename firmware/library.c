@@ -0,0 +1,103 @@
+/*
+ * ROM library in flash for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+
+#include "library.h"
+
+#define LIBRARY_FLASH_TIMEOUT_MS    1000
+
+// Start of the library region, defined in memmap_custom.ld
+//
+extern const uint8_t library[LIBRARY_NUM_PAGES * LIBRARY_PAGE_SIZE];
+
+typedef struct {
+    uint32_t        offset;             // From the start of the flash
+    const uint8_t   *data;
+    uint32_t        len;
+} library_op_t;
+
+static void library_do_erase( void *param )
+{
+    library_op_t *op = param;
+
+    flash_range_erase( op->offset, op->len );
+}
+
+static void library_do_program( void *param )
+{
+    library_op_t *op = param;
+
+    flash_range_program( op->offset, op->data, op->len );
+}
+
+static inline uint32_t library_offset( int page )
+{
+    return ( ( uint32_t )( uintptr_t )library - XIP_BASE + page * LIBRARY_PAGE_SIZE );
+}
+
+// Pointer to the page, read through the XIP cache
+//
+const uint8_t *library_page( int page )
+{
+    return ( &library[page * LIBRARY_PAGE_SIZE] );
+}
+
+// Flash can't be read while it is erased or programmed. The binary runs from
+// RAM, but flash_safe_execute() also stops core 1 in case the bank device is
+// reading the library. The memory emulation is all DMA, so the KIM-1 keeps
+// running, but a page erase holds core 1 for tens of ms. If the 6502 writes
+// enough in the meantime for the write tap to wrap, the device loop counts an
+// overrun and the device register writes in between are lost, and the cycles
+// logged by the cycle monitor are left unclassified
+//
+bool library_erase( int page )
+{
+    library_op_t op = { .offset = library_offset( page ), .len = LIBRARY_PAGE_SIZE };
+
+    if ( page < 0 || page >= LIBRARY_NUM_PAGES )
+    {
+        return ( false );
+    }
+
+    return ( flash_safe_execute( library_do_erase, &op, LIBRARY_FLASH_TIMEOUT_MS ) == PICO_OK );
+}
+
+// Program len bytes at offset from the start of an erased page. Both must be
+// multiples of LIBRARY_CHUNK_SIZE
+//
+bool library_program( int page, uint32_t offset, const uint8_t *data, uint32_t len )
+{
+    library_op_t op = { .offset = library_offset( page ) + offset, .data = data, .len = len };
+
+    if ( page < 0 || page >= LIBRARY_NUM_PAGES || offset + len > LIBRARY_PAGE_SIZE
+        || offset % LIBRARY_CHUNK_SIZE || len % LIBRARY_CHUNK_SIZE )
+    {
+        return ( false );
+    }
+
+    return ( flash_safe_execute( library_do_program, &op, LIBRARY_FLASH_TIMEOUT_MS ) == PICO_OK );
+}
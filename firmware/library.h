@@ -0,0 +1,42 @@
+/*
+ * ROM library in flash for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The library is a region of flash, reserved by the linker script, that
+// holds ROM images for the KIM-1. It is divided in pages of one flash
+// sector, that are erased and written as a whole, and is read in place
+//
+#define LIBRARY_PAGE_SIZE   4096        // One flash sector
+#define LIBRARY_NUM_PAGES   256         // 1 MB, see memmap_custom.ld
+#define LIBRARY_ROM_PAGES   192         // ROM images for the bank device. The rest hold the program library
+#define LIBRARY_CHUNK_SIZE  256         // Flash programming unit
+
+const uint8_t *library_page( int page );
+bool library_erase( int page );
+bool library_program( int page, uint32_t offset, const uint8_t *data, uint32_t len );
+
+#endif /* LIBRARY_H */
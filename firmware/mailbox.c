@@ -0,0 +1,196 @@
+/*
+ * Host to KIM-1 mailbox for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "config.h"
+#include "mememul.h"
+#include "mailbox.h"
+
+static struct {
+    bool        configured;
+    uint16_t    address;
+    int         size;
+    mememul_tap_cursor_t cursor;        // Write tap cursor
+    bool        rung;                   // The out ring may have data
+    uint32_t    checked;                // Time of the last fallback check
+} mailbox;
+
+static inline volatile uint8_t *mailbox_byte( int offset )
+{
+    return ( volatile uint8_t * )&mem_map[mailbox.address + offset];
+}
+
+// Set up the mailbox at the given address. The whole area must be enabled RAM,
+// so the 6502 can update it. The rings are emptied and the doorbell cleared
+//
+bool mailbox_setup( uint16_t address, int size )
+{
+    int len = MAILBOX_HEADER_LEN + 2 * size;
+
+    if ( size < 2 || size > MAILBOX_MAX_SIZE || address + len > MEM_MAP_SIZE )
+    {
+        return ( false );
+    }
+
+    for ( int i = 0; i < len; ++i )
+    {
+        if ( ( mem_map[address + i] & MEM_ATTR_MASK ) != ( MEM_ATTR_ENABLED | MEM_ATTR_WRITEABLE ) )
+        {
+            return ( false );
+        }
+    }
+
+    mailbox.address = address;
+    mailbox.size = size;
+
+    for ( int i = 0; i < MAILBOX_HEADER_LEN; ++i )
+    {
+        *mailbox_byte( i ) = 0;
+    }
+
+    mememul_tap_cursor( &mailbox.cursor );
+    mailbox.rung = false;
+    mailbox.checked = time_us_32();
+    mailbox.configured = true;
+
+    return ( true );
+}
+
+bool mailbox_configured( void )
+{
+    return ( mailbox.configured );
+}
+
+// Add data to the in ring. Returns the number of bytes added, which is less
+// than requested if it fills up
+//
+int mailbox_put( const uint8_t *data, int len )
+{
+    int head = *mailbox_byte( MAILBOX_IN_HEAD ) % mailbox.size;
+    int tail = *mailbox_byte( MAILBOX_IN_TAIL ) % mailbox.size;
+    int n;
+
+    for ( n = 0; n < len && ( head + 1 ) % mailbox.size != tail; ++n )
+    {
+        *mailbox_byte( MAILBOX_HEADER_LEN + head ) = data[n];
+        head = ( head + 1 ) % mailbox.size;
+    }
+
+    // The data must be in place before the 6502 sees the new head
+    //
+    __sync_synchronize();
+    *mailbox_byte( MAILBOX_IN_HEAD ) = head;
+
+    return ( n );
+}
+
+// Drain the out ring. Returns the number of bytes taken
+//
+int mailbox_get( uint8_t *data, int size )
+{
+    int head = *mailbox_byte( MAILBOX_OUT_HEAD ) % mailbox.size;
+    int tail = *mailbox_byte( MAILBOX_OUT_TAIL ) % mailbox.size;
+    int n;
+
+    __sync_synchronize();
+
+    for ( n = 0; n < size && tail != head; ++n )
+    {
+        data[n] = *mailbox_byte( MAILBOX_HEADER_LEN + mailbox.size + tail );
+        tail = ( tail + 1 ) % mailbox.size;
+    }
+
+    __sync_synchronize();
+    *mailbox_byte( MAILBOX_OUT_TAIL ) = tail;
+
+    mailbox.rung = false;
+
+    return ( n );
+}
+
+// True if the 6502 has added data to the out ring
+//
+bool mailbox_ready( void )
+{
+    return ( mailbox.configured && mailbox.rung
+                && *mailbox_byte( MAILBOX_OUT_HEAD ) != *mailbox_byte( MAILBOX_OUT_TAIL ) );
+}
+
+// Follow the 6502 writes for the doorbell, so waiting requests complete as
+// soon as it is rung. If the write tap wrapped, the doorbell could be among
+// the lost writes, so it counts as rung. The out ring is also checked every
+// MAILBOX_POLL_MS, in case the program does not use the doorbell
+//
+void mailbox_poll( void )
+{
+    uint16_t address;
+    uint32_t now, overruns = mailbox.cursor.overruns;
+
+    if ( !mailbox.configured )
+    {
+        return;
+    }
+
+    while ( mememul_tap_next( &mailbox.cursor, &address ) )
+    {
+        if ( address == mailbox.address + MAILBOX_DOORBELL )
+        {
+            mailbox.rung = true;
+        }
+    }
+
+    if ( mailbox.cursor.overruns != overruns )
+    {
+        mailbox.rung = true;
+    }
+
+    now = time_us_32();
+
+    if ( now - mailbox.checked >= MAILBOX_POLL_MS * 1000 )
+    {
+        mailbox.checked = now;
+        mailbox.rung = true;
+    }
+}
+
+// Mailbox layout as JSON. Returns the length, or -1 if it does not fit
+//
+int mailbox_json( char *buf, int size )
+{
+    int n;
+
+    if ( !mailbox.configured )
+    {
+        n = snprintf( buf, size, "{}" );
+    }
+    else
+    {
+        n = snprintf( buf, size, "{\"address\":\"%04x\",\"size\":%d,\"in\":\"%04x\",\"out\":\"%04x\"}",
+                        mailbox.address, mailbox.size, mailbox.address + MAILBOX_HEADER_LEN,
+                        mailbox.address + MAILBOX_HEADER_LEN + mailbox.size );
+    }
+
+    return ( n < size ? n : -1 );
+}
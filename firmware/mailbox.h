@@ -0,0 +1,55 @@
+/*
+ * Host to KIM-1 mailbox for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Mailbox layout in the KIM-1 memory, from its base address. Each ring has
+// a head, written by the producer, and a tail, written by the consumer.
+// Both are offsets into the ring data, and a ring is empty when they are
+// equal, so it holds up to size - 1 bytes.
+//
+#define MAILBOX_DOORBELL    0           // Written by the 6502 after adding to the out ring
+#define MAILBOX_IN_HEAD     1           // Host to KIM-1 ring, written by the card
+#define MAILBOX_IN_TAIL     2           // Written by the 6502
+#define MAILBOX_OUT_HEAD    3           // KIM-1 to host ring, written by the 6502
+#define MAILBOX_OUT_TAIL    4           // Written by the card
+#define MAILBOX_HEADER_LEN  8           // The in ring data follows, then the out ring data
+
+#define MAILBOX_SIZE        64          // Default ring size
+#define MAILBOX_MAX_SIZE    128
+#define MAILBOX_POLL_MS     10          // Check the out ring for programs that do not ring the doorbell
+#define MAILBOX_WAIT_MS     30000       // Default long poll timeout
+#define MAILBOX_MAX_WAIT_MS 600000
+
+bool mailbox_setup( uint16_t address, int size );
+bool mailbox_configured( void );
+int mailbox_put( const uint8_t *data, int len );
+int mailbox_get( uint8_t *data, int size );
+bool mailbox_ready( void );
+void mailbox_poll( void );
+int mailbox_json( char *buf, int size );
+
+#endif /* MAILBOX_H */
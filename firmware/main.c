@@ -23,12 +23,25 @@
 #include <stdint.h>
 #include <stdio.h>
 #include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/flash.h"
 
 #include "config.h"
 #include "mememul.h"
 #include "video.h"
 #include "wlan.h"
 #include "webserver.h"
+#include "devices.h"
+
+// Core 1 entry. It must allow core 0 to pause it while the ROM library
+// in flash is written
+//
+static void core1_main( void )
+{
+    flash_safe_execute_core_init();
+
+    devices_run();
+}
 
 void main( void )
 {
@@ -46,6 +59,10 @@ void main( void )
     //
     mememul_setup( &mem_map[0] );
     video_setup( &mem_map[0] );
+
+    // Memory mapped devices run on core 1, following the 6502 writes
+    //
+    multicore_launch_core1( core1_main );
     
     // Setup wireless network. This function only returns if connection is
     // successful.
@@ -0,0 +1,230 @@
+/*
+ * Math unit for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "config.h"
+#include "mathunit.h"
+
+#define MATH_FLOAT_BIAS     128
+
+static inline volatile uint8_t *mathunit_byte( uint16_t address )
+{
+    return ( volatile uint8_t * )&mem_map[address];
+}
+
+static uint32_t mathunit_get_int( uint16_t address, int len )
+{
+    uint32_t value = 0;
+
+    while ( len-- )
+    {
+        value = value << 8 | *mathunit_byte( address + len );
+    }
+
+    return ( value );
+}
+
+static void mathunit_set_int( uint16_t address, uint64_t value, int len )
+{
+    for ( int i = 0; i < len; ++i, value >>= 8 )
+    {
+        *mathunit_byte( address + i ) = value & 0xFF;
+    }
+}
+
+// The 32 bit mantissa fits in a double, so the conversion is exact
+//
+static double mathunit_get_float( uint16_t address )
+{
+    uint8_t exp = *mathunit_byte( address );
+    uint32_t mantissa = 0;
+
+    if ( !exp )
+    {
+        return ( 0.0 );
+    }
+
+    for ( int i = 1; i < 5; ++i )
+    {
+        mantissa = mantissa << 8 | *mathunit_byte( address + i );
+    }
+
+    double value = ldexp( mantissa | 0x80000000, exp - MATH_FLOAT_BIAS - 32 );
+
+    return ( mantissa & 0x80000000 ? -value : value );
+}
+
+// Round the value to a 32 bit mantissa and store it. Underflows store zero,
+// as BASIC does. Returns false on overflow
+//
+static bool mathunit_set_float( uint16_t address, double value )
+{
+    uint64_t mantissa;
+    int exp;
+
+    if ( !isfinite( value ) )
+    {
+        return ( false );
+    }
+
+    value = frexp( value, &exp );
+    mantissa = llround( ldexp( fabs( value ), 32 ) );
+
+    if ( mantissa >> 32 )
+    {
+        mantissa >>= 1;
+        ++exp;
+    }
+
+    exp += MATH_FLOAT_BIAS;
+
+    if ( exp > 0xFF )
+    {
+        return ( false );
+    }
+
+    if ( !mantissa || exp <= 0 )
+    {
+        mathunit_set_int( address, 0, 5 );
+        return ( true );
+    }
+
+    mantissa &= 0x7FFFFFFF;
+
+    if ( value < 0 )
+    {
+        mantissa |= 0x80000000;
+    }
+
+    *mathunit_byte( address ) = exp;
+
+    for ( int i = 4; i > 0; --i, mantissa >>= 8 )
+    {
+        *mathunit_byte( address + i ) = mantissa & 0xFF;
+    }
+
+    return ( true );
+}
+
+static bool mathunit_divide( uint16_t base, int len )
+{
+    uint32_t a = mathunit_get_int( base + MATH_A, len );
+    uint32_t b = mathunit_get_int( base + MATH_B, len );
+
+    if ( !b )
+    {
+        return ( false );
+    }
+
+    mathunit_set_int( base + MATH_R, a / b, len );
+    mathunit_set_int( base + MATH_REM, a % b, len );
+
+    return ( true );
+}
+
+// Called from core 1 on each 6502 write to the registers. Writing an operation
+// to the command register runs it. The register keeps the operation, with
+// bit 7 set, so the 6502 sees it busy, until it is replaced by the status.
+//
+// The command is only picked up when the core 1 loop gets to the write, after
+// the other devices and the statistics, so the 6502 must poll the command
+// register until bit 7 clears before reading the result
+//
+void mathunit_write( uint16_t base, int reg, uint8_t value )
+{
+    uint8_t status = MATH_DONE;
+    double a, b;
+    bool ok = true;
+
+    if ( reg != MATH_CMD )
+    {
+        return;
+    }
+
+    switch ( value )
+    {
+        case MATH_MUL16:
+            mathunit_set_int( base + MATH_R,
+                    mathunit_get_int( base + MATH_A, 2 ) * mathunit_get_int( base + MATH_B, 2 ), 4 );
+            break;
+
+        case MATH_DIV16:
+            ok = mathunit_divide( base, 2 );
+            break;
+
+        case MATH_MUL32:
+            mathunit_set_int( base + MATH_R,
+                    ( uint64_t ) mathunit_get_int( base + MATH_A, 4 ) * mathunit_get_int( base + MATH_B, 4 ), 8 );
+            break;
+
+        case MATH_DIV32:
+            ok = mathunit_divide( base, 4 );
+            break;
+
+        case MATH_FADD:
+        case MATH_FSUB:
+        case MATH_FMUL:
+        case MATH_FDIV:
+            a = mathunit_get_float( base + MATH_A );
+            b = mathunit_get_float( base + MATH_B );
+
+            if ( value == MATH_FADD )
+            {
+                ok = mathunit_set_float( base + MATH_R, a + b );
+            }
+            else if ( value == MATH_FSUB )
+            {
+                ok = mathunit_set_float( base + MATH_R, a - b );
+            }
+            else if ( value == MATH_FMUL )
+            {
+                ok = mathunit_set_float( base + MATH_R, a * b );
+            }
+            else
+            {
+                ok = b != 0.0 && mathunit_set_float( base + MATH_R, a / b );
+            }
+            break;
+
+        case MATH_FSQR:
+            a = mathunit_get_float( base + MATH_A );
+            ok = a >= 0.0 && mathunit_set_float( base + MATH_R, sqrt( a ) );
+            break;
+
+        default:
+            status = MATH_ERROR;
+            break;
+    }
+
+    if ( !ok )
+    {
+        status = MATH_FAIL;
+    }
+
+    // The result must be in place before the 6502 sees the status
+    //
+    __sync_synchronize();
+    *mathunit_byte( base + MATH_CMD ) = status;
+}
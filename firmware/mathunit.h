@@ -0,0 +1,57 @@
+/*
+ * Math unit for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef MATHUNIT_H
+#define MATHUNIT_H
+
+#include <stdint.h>
+
+// Math unit registers, from the device base address. Integers are unsigned
+// and little endian. Floats are in the 5 byte packed format of Microsoft
+// BASIC for the 6502: exponent with a bias of 128, 0 for zero, then the
+// mantissa, most significant byte first, with the sign in place of its
+// leading 1 bit
+//
+#define MATH_A              0           // First operand
+#define MATH_B              5           // Second operand
+#define MATH_R              10          // Result. Division leaves the quotient here
+#define MATH_REM            14          //   and the remainder here
+#define MATH_CMD            18          // Write an operation to start
+#define MATH_NUM_REGS       19
+
+#define MATH_MUL16          0x80        // Operations. R = A * B, 32 bit result
+#define MATH_DIV16          0x81        // R = A / B, REM = A % B
+#define MATH_MUL32          0x82        // R = A * B, 64 bit result
+#define MATH_DIV32          0x83        // R = A / B, REM = A % B
+#define MATH_FADD           0x88        // R = A + B
+#define MATH_FSUB           0x89        // R = A - B
+#define MATH_FMUL           0x8A        // R = A * B
+#define MATH_FDIV           0x8B        // R = A / B
+#define MATH_FSQR           0x8C        // R = sqrt( A )
+
+#define MATH_DONE           0x00        // Status values, replace the operation when done
+#define MATH_FAIL           0x01        // Division by zero, overflow or square root of a negative
+#define MATH_ERROR          0xFF        // Unknown operation
+
+void mathunit_write( uint16_t base, int reg, uint8_t value );
+
+#endif /* MATHUNIT_H */
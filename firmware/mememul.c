@@ -23,11 +23,29 @@
 #include "pico/stdlib.h"
 #include "hardware/pio.h"
 #include "hardware/dma.h"
+#include "hardware/structs/timer.h"
 
 #include "mememul.pio.h"
 
 #include "pins.h"
 #include "dmacfg.h"
+#include "mememul.h"
+
+// Write tap. Every completed write_data_dma transfer chains to tap_dma, which
+// logs the write address of write_data_dma into a ring, so the writes of the
+// 6502 can be followed without any CPU intervention. Then stamp_dma logs the
+// time of the write into a second ring, in step with the first one, so a
+// reader can tell if the ring has wrapped since it last read it
+//
+static uint32_t tap_ring[MEMEMUL_TAP_SIZE] __attribute__(( aligned( MEMEMUL_TAP_SIZE * sizeof( uint32_t ) ) ));
+static uint32_t tap_stamps[MEMEMUL_TAP_SIZE] __attribute__(( aligned( MEMEMUL_TAP_SIZE * sizeof( uint32_t ) ) ));
+static int tap_dma = -1;
+static int stamp_dma = -1;
+
+// Channel that reads the data of every bus cycle. Its read address is that of
+// the last cycle, which is used by the execution profiler
+//
+static int read_data_dma = -1;
 
 static void mememul_gpio_pins( PIO pio )
 {
@@ -104,6 +122,110 @@ static int mememul_create_memwrite_sm( PIO pio )
     return memwrite_sm;
 }
 
+// Cycle monitor. A state machine on PIO 0 samples the address, data, CE and
+// RW of every bus cycle, and pagemon_dma logs the samples into a ring, at normal
+// priority, so the memory emulation channels are not delayed. The transfer
+// count of the channel is also the count of bus cycles. It runs from the start
+//
+#define PAGEMON_PAGE_SHIFT  8           // A8-A15 position in the sample, next to the data
+#define PAGEMON_CE_SHIFT    20          // CE position in the sample, low if the card serves the cycle
+#define PAGEMON_RW_SHIFT    21          // RW position in the sample, high for reads
+#define PAGEMON_LOW_SHIFT   22          // A0-A7 position in the sample
+#define PAGEMON_COUNT       0xFFFFFFFF  // Transfer count. There is no endless mode
+
+static uint32_t pagemon_ring[MEMEMUL_PAGEMON_SIZE] __attribute__(( aligned( MEMEMUL_PAGEMON_SIZE * sizeof( uint32_t ) ) ));
+static int pagemon_dma;
+static uint32_t pagemon_base = 0;       // Count of the previous runs of the channel
+
+static void mememul_create_pagemon_sm( PIO pio )
+{
+    int pagemon_sm  = pio_claim_unused_sm( pio, true );                                     // Claim a free state machine for the cycle monitor on PIO 0
+    uint offset     = pio_add_program( pio, &pagemon_program );                             // Instruction memory offset for the SM
+
+    pio_sm_config pagemon_config = pagemon_program_get_default_config( offset );            // Get default config for the cycle monitor SM
+
+    sm_config_set_in_pins ( &pagemon_config, PIN_BASE_ADDR );                               // Pin set for IN instructions
+    sm_config_set_in_shift ( &pagemon_config, false, true, 32 );                            // Shift left and autopush the whole sample
+    sm_config_set_fifo_join( &pagemon_config, PIO_FIFO_JOIN_RX );                           // 8 entry RX FiFo
+    sm_config_set_clkdiv_int_frac( &pagemon_config, 2, 0 );                                 // Half speed, so a single delay covers the bus settling time
+
+    pio_sm_init( pio, pagemon_sm, offset, &pagemon_config );
+
+    pagemon_dma = dma_claim_unused_channel( true );
+
+    dma_channel_config pagemon_dma_config = dmacfg_config_channel(
+                pagemon_dma,
+                false,                                                      // Normal priority, the bus cycle does not wait for it
+                pio_get_dreq( pio, pagemon_sm, false ),                     // Signals data transfer from PIO, receive
+                DMA_SIZE_32,
+                pagemon_dma,                                                // Does not chain
+                pagemon_ring,                                               // Writes to the cycle monitor ring
+                &pio->rxf[pagemon_sm],                                      // Reads from pagemon_sm RX FiFo
+                PAGEMON_COUNT,                                              // Transfer until the count runs out
+                false,                                                      // Don't do byte swapping
+                true,                                                       // Increment write addr
+                false,                                                      // Do not increment read addr
+                false                                                       // Starts after setting the ring
+                );
+
+    channel_config_set_ring( &pagemon_dma_config, true, MEMEMUL_PAGEMON_RING_BITS );   // Wrap around the ring
+    dma_channel_set_config( pagemon_dma, &pagemon_dma_config, true );
+
+    pio_sm_set_enabled( pio, pagemon_sm, true );
+}
+
+// Bus cycles since the start, modulo 2^32. The transfer count runs out after
+// more than an hour at 1 MHz, and then the channel is started again. Only
+// core 1 calls it, often enough for no cycle to be missed. The ring is written
+// from its start, so the sample of a cycle is at its count modulo the ring
+// size, and a single read gives both
+//
+uint32_t mememul_pagemon_count( void )
+{
+    uint32_t remaining;
+
+    if ( !( remaining = dma_channel_hw_addr( pagemon_dma )->transfer_count ) )
+    {
+        pagemon_base += PAGEMON_COUNT;
+        dma_channel_set_trans_count( pagemon_dma, PAGEMON_COUNT, true );
+        remaining = PAGEMON_COUNT;
+    }
+
+    return pagemon_base + PAGEMON_COUNT - remaining;
+}
+
+// Position of the next sample to be logged in the ring
+//
+static uint32_t mememul_pagemon_cursor( void )
+{
+    return ( dma_channel_hw_addr( pagemon_dma )->write_addr - ( uint32_t ) pagemon_ring ) / sizeof( uint32_t );
+}
+
+// Get the address, the data, whether the card served it and the direction of
+// the next logged cycle after the cursor. Returns false if there are none. The
+// caller tells if the ring has wrapped from the cycle count. The data is only
+// that of the bus if the card served the cycle
+//
+bool mememul_pagemon_next( uint32_t *cursor, uint16_t *address, uint8_t *data, bool *card, bool *read )
+{
+    uint32_t sample;
+
+    if ( *cursor == mememul_pagemon_cursor() )
+    {
+        return false;
+    }
+
+    sample = pagemon_ring[*cursor];
+
+    *address = ( ( sample >> PAGEMON_PAGE_SHIFT ) & 0xFF ) << 8 | ( ( sample >> PAGEMON_LOW_SHIFT ) & 0xFF );
+    *data = sample & 0xFF;
+    *card = !( ( sample >> PAGEMON_CE_SHIFT ) & 1 );
+    *read = ( sample >> PAGEMON_RW_SHIFT ) & 1;
+    *cursor = ( *cursor + 1 ) % MEMEMUL_PAGEMON_SIZE;
+
+    return true;
+}
+
 void mememul_setup( uint16_t *mem_map )
 {
     // Configure PIO
@@ -126,19 +248,61 @@ void mememul_setup( uint16_t *mem_map )
     // * Channel read_addr_dma:  Moves address from memread_sm RX FiFo ( addr bus combined with the mem_map base address) to the read_data_dma channel config read address. Chains to write_addr_dma
     // * Channel write_addr_dma: Moves address from read_data_dma channel config read address to the write_data_dma channel config write trigger address. Chains to read_data_dma.
     // * Channel read_data_dma:  Moves data from mem_map (as previosly set by read_addr_dma) to memread_sm TX FiFo. Chains to read_addr_dma
-    // * Channel write_data_dma: Moves data from memwrite_sm RX FiFo to the mem_map addr configured by write_addr_dma. Does not chain.
+    // * Channel write_data_dma: Moves data from memwrite_sm RX FiFo to the mem_map addr configured by write_addr_dma. Chains to tap_dma.
+    //
+    // * Channel tap_dma:        Logs the write address of write_data_dma into tap_ring when it finishes. Chains to stamp_dma.
+    // * Channel stamp_dma:      Logs the time of the write into tap_stamps.
     //
     int read_addr_dma   = dma_claim_unused_channel( true );
-    int read_data_dma   = dma_claim_unused_channel( true );
+    read_data_dma       = dma_claim_unused_channel( true );
     int write_addr_dma  = dma_claim_unused_channel( true );
     int write_data_dma  = dma_claim_unused_channel( true );
 
+    tap_dma             = dma_claim_unused_channel( true );
+    stamp_dma           = dma_claim_unused_channel( true );
+
+    dma_channel_config stamp_dma_config = dmacfg_config_channel(
+                stamp_dma,
+                false,                                                      // Normal priority, the bus cycle does not wait for it
+                DREQ_FORCE,                                                 // Permanent request transfer
+                DMA_SIZE_32,
+                stamp_dma,                                                  // Does not chain
+                tap_stamps,                                                 // Writes to the stamp ring
+                &timer_hw->timerawl,                                        // Reads from the microsecond timer
+                1,                                                          // Transfer 1 dword
+                false,                                                      // Don't do byte swapping
+                true,                                                       // Increment write addr
+                false,                                                      // Do not increment read addr
+                false                                                       // Does not start
+                );
+
+    channel_config_set_ring( &stamp_dma_config, true, MEMEMUL_TAP_RING_BITS ); // Wrap around the stamp ring
+    dma_channel_set_config( stamp_dma, &stamp_dma_config, false );
+
+    dma_channel_config tap_dma_config = dmacfg_config_channel(
+                tap_dma,
+                false,                                                      // Normal priority, the bus cycle does not wait for it
+                DREQ_FORCE,                                                 // Permanent request transfer
+                DMA_SIZE_32,
+                stamp_dma,                                                  // Chains to stamp_dma, to stamp the write
+                tap_ring,                                                   // Writes to the tap ring
+                &dma_channel_hw_addr(write_data_dma)->write_addr,           // Reads from write address of write_data_dma
+                1,                                                          // Transfer 1 dword
+                false,                                                      // Don't do byte swapping
+                true,                                                       // Increment write addr
+                false,                                                      // Do not increment read addr
+                false                                                       // Does not start
+                );
+
+    channel_config_set_ring( &tap_dma_config, true, MEMEMUL_TAP_RING_BITS );   // Wrap around the tap ring
+    dma_channel_set_config( tap_dma, &tap_dma_config, false );
+
     dma_channel_config write_data_dma_config = dmacfg_config_channel(
                 write_data_dma,
                 true,                                                       // Mark as high priority
                 pio_get_dreq( pio, memwrite_sm, false ),                    // Signals data transfer from PIO, receive
                 DMA_SIZE_8,
-                write_data_dma,                                             // Does not chain (chain to itself means no chain)
+                tap_dma,                                                    // Chains to tap_dma, to log the write
                 mem_map,                                                    // Writes to mem_map (efective address configured by write_addr_dma)
                 &pio->rxf[memwrite_sm],                                     // Reads from memwrite_sm RX FiFo
                 1,                                                          // Transfer 1 byte
@@ -202,5 +366,172 @@ void mememul_setup( uint16_t *mem_map )
     pio_sm_put( pio, memread_sm, dma_channel_hw_addr( read_data_dma )->read_addr >> 17 );
     pio_sm_set_enabled( pio, memread_sm, true );
 
+    // The cycle monitor follows the bus from the start
+    //
+    mememul_create_pagemon_sm( pio );
+}
+
+// Position of the next write to be logged in the tap ring. The stamp is
+// written last, so an entry is complete once the stamp ring has moved past it
+//
+static inline uint32_t mememul_tap_index( void )
+{
+    return ( dma_channel_hw_addr( stamp_dma )->write_addr - ( uint32_t ) tap_stamps ) / sizeof( uint32_t );
 }
 
+// Place a reader of the tap at the current position
+//
+void mememul_tap_cursor( mememul_tap_cursor_t *cursor )
+{
+    cursor->index = mememul_tap_index();
+    cursor->stamp = tap_stamps[( cursor->index + MEMEMUL_TAP_SIZE - 1 ) % MEMEMUL_TAP_SIZE];
+}
+
+// Get the address of the next logged write after the cursor. Returns false
+// if there are none, or if the ring has wrapped since the last call. Then the
+// writes in between are lost, the overrun is counted and the cursor is moved
+// to the current position. The entry before the cursor is the last one read,
+// and the ring is written in order, so if its stamp has changed the writes
+// have reached the cursor again
+//
+bool mememul_tap_next( mememul_tap_cursor_t *cursor, uint16_t *address )
+{
+    uint32_t entry, stamp, last = ( cursor->index + MEMEMUL_TAP_SIZE - 1 ) % MEMEMUL_TAP_SIZE;
+    bool pending = ( cursor->index != mememul_tap_index() );
+
+    // If the entry is overwritten while it is read, the one before has been
+    // overwritten first, or its stamp changes before the next call
+    //
+    stamp = tap_stamps[cursor->index];
+    entry = tap_ring[cursor->index];
+    __sync_synchronize();
+
+    if ( tap_stamps[last] != cursor->stamp )
+    {
+        ++cursor->overruns;
+        mememul_tap_cursor( cursor );
+
+        return false;
+    }
+
+    if ( !pending )
+    {
+        return false;
+    }
+
+    // mem_map is aligned to 128K, so the low 17 bits of the pointer are the
+    // offset of the 16 bit entry
+    //
+    *address = ( entry & 0x1FFFF ) >> 1;
+    cursor->stamp = stamp;
+    cursor->index = ( cursor->index + 1 ) % MEMEMUL_TAP_SIZE;
+
+    return true;
+}
+
+// Bus monitor. A state machine on PIO 1 samples the bus on every cycle, like
+// memread, and pushes the accesses to a single aligned block. The PIO 1
+// program memory is almost full with the video programs, so it is loaded
+// the first time it is needed
+//
+#define BUSMON_PIO          pio1
+#define BUSMON_REG_SHIFT    16          // A0-A1 position in the pushed sample
+#define BUSMON_RW_SHIFT     5           // RW position in the pushed sample, high for reads
+
+static int busmon_sm = -1;
+static uint busmon_offset;
+
+static void mememul_create_busmon_sm( PIO pio )
+{
+    busmon_sm       = pio_claim_unused_sm( pio, true );                                     // Claim a free state machine for the bus monitor on PIO 1
+    busmon_offset   = pio_add_program( pio, &busmon_program );                              // Instruction memory offset for the SM
+
+    pio_sm_config busmon_config = busmon_program_get_default_config( busmon_offset );       // Get default config for the bus monitor SM
+
+    sm_config_set_in_pins ( &busmon_config, PIN_BASE_ADDR + 2 );                            // Pin set for IN and MOV instructions, from A2
+    sm_config_set_in_shift ( &busmon_config, false, true, 32 );                             // Autopush the whole sample
+    sm_config_set_out_shift( &busmon_config, true, false, 32 );                             // Shift right to get the address, no autopull
+    sm_config_set_fifo_join( &busmon_config, PIO_FIFO_JOIN_RX );                            // 8 entry RX FiFo
+    sm_config_set_clkdiv_int_frac( &busmon_config, 2, 0 );                                  // Half speed, so a single delay covers the bus settling time
+
+    pio_sm_init( pio, busmon_sm, busmon_offset, &busmon_config );
+}
+
+// Start following the accesses to the MEMEMUL_BUSMON_BLOCK bytes at address,
+// which must be aligned
+//
+void mememul_busmon_start( uint16_t address )
+{
+    if ( busmon_sm < 0 )
+    {
+        mememul_create_busmon_sm( BUSMON_PIO );
+    }
+
+    pio_sm_set_enabled( BUSMON_PIO, busmon_sm, false );
+    pio_sm_clear_fifos( BUSMON_PIO, busmon_sm );
+    pio_sm_restart( BUSMON_PIO, busmon_sm );
+
+    // Load the block address into y and start from the beginning
+    //
+    pio_sm_put( BUSMON_PIO, busmon_sm, address / MEMEMUL_BUSMON_BLOCK );
+    pio_sm_exec( BUSMON_PIO, busmon_sm, pio_encode_pull( false, true ) );
+    pio_sm_exec( BUSMON_PIO, busmon_sm, pio_encode_mov( pio_y, pio_osr ) );
+    pio_sm_exec( BUSMON_PIO, busmon_sm, pio_encode_jmp( busmon_offset ) );
+
+    pio_sm_set_enabled( BUSMON_PIO, busmon_sm, true );
+}
+
+void mememul_busmon_stop( void )
+{
+    if ( busmon_sm >= 0 )
+    {
+        pio_sm_set_enabled( BUSMON_PIO, busmon_sm, false );
+    }
+}
+
+// Get the next access to the block: register number and direction. Returns
+// false if there are none. If the FiFo fills up, the state machine stalls
+// and the accesses in the meantime are lost
+//
+bool mememul_busmon_next( int *reg, bool *read )
+{
+    uint32_t sample;
+
+    if ( busmon_sm < 0 || pio_sm_is_rx_fifo_empty( BUSMON_PIO, busmon_sm ) )
+    {
+        return false;
+    }
+
+    sample = pio_sm_get( BUSMON_PIO, busmon_sm );
+
+    *reg = ( sample >> BUSMON_REG_SHIFT ) & ( MEMEMUL_BUSMON_BLOCK - 1 );
+    *read = ( sample >> BUSMON_RW_SHIFT ) & 1;
+
+    return true;
+}
+
+// Address of the bus cycle in progress. The address is taken from the read
+// address of read_data_dma, which memread updates on every cycle, when PHI2
+// is high, so it is not the one of the previous cycle. Returns false if there
+// is no bus clock
+//
+#define BUS_ADDRESS_WAIT    64          // Tries to wait for PHI2 high, well over a cycle
+
+bool mememul_bus_address( uint16_t *address )
+{
+    int tries = BUS_ADDRESS_WAIT;
+
+    while ( !gpio_get( PHI2 ) )
+    {
+        if ( !--tries )
+        {
+            return false;
+        }
+    }
+
+    // mem_map is aligned to 128K, as in the write tap
+    //
+    *address = ( dma_channel_hw_addr( read_data_dma )->read_addr & 0x1FFFF ) >> 1;
+
+    return true;
+}
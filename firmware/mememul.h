@@ -24,7 +24,31 @@
 #define MEMEMUL_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#define MEMEMUL_TAP_RING_BITS   11                                  // Write tap ring of 2^11 bytes
+#define MEMEMUL_TAP_SIZE        ( ( 1 << MEMEMUL_TAP_RING_BITS ) / 4 ) // Writes logged
+#define MEMEMUL_BUSMON_BLOCK    4                                   // Addresses followed by the bus monitor
+#define MEMEMUL_PAGEMON_RING_BITS 13                                // Cycle monitor ring of 2^13 bytes
+#define MEMEMUL_PAGEMON_SIZE    ( ( 1 << MEMEMUL_PAGEMON_RING_BITS ) / 4 ) // Samples logged
+
+// Reader of the write tap. Each reader keeps its own, so the tap can be
+// followed from both cores
+//
+typedef struct {
+    uint32_t index;                     // Next entry to read
+    uint32_t stamp;                     // Stamp of the entry before it, to detect a wrap
+    uint32_t overruns;                  // Times the ring wrapped before it was read
+} mememul_tap_cursor_t;
 
 void mememul_setup( uint16_t *mem_map );
+void mememul_tap_cursor( mememul_tap_cursor_t *cursor );
+bool mememul_tap_next( mememul_tap_cursor_t *cursor, uint16_t *address );
+void mememul_busmon_start( uint16_t address );
+void mememul_busmon_stop( void );
+bool mememul_busmon_next( int *reg, bool *read );
+uint32_t mememul_pagemon_count( void );
+bool mememul_pagemon_next( uint32_t *cursor, uint16_t *address, uint8_t *data, bool *card, bool *read );
+bool mememul_bus_address( uint16_t *address );
 
 #endif /* MEMEMUL_H */
@@ -0,0 +1,492 @@
+/*
+ * Live memory monitor for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "config.h"
+#include "picowi.h"
+#include "httpd.h"
+#include "websocket.h"
+#include "monitor.h"
+
+// Frames are sent one per segment, and each one must be acknowledged before
+// the next is built. Changes are sent as records of an address, little endian,
+// a byte count and the data.
+//
+#define MONITOR_FRAME_LEN   ( TCP_MSS - TCP_DATA_OFFSET )
+#define MONITOR_RECORD_LEN  3
+#define MONITOR_MAX_RUN     255
+
+typedef struct {
+    uint16_t    start;
+    uint16_t    count;
+    uint16_t    shadow;                         // Offset of its copy in the shadow buffer
+    uint16_t    synced;                         // Bytes below this have been sent at least once
+} monitor_range_t;
+
+typedef struct {
+    bool        active;
+    int         sock;
+    uint32_t    start_seq;                      // Identifies the connection on the socket
+    uint32_t    interval;                       // Compare interval, in us
+    uint32_t    last;                           // Time of the last compare
+    bool        more;                           // Last frame was full, do not wait for the interval
+    int         next;                           // Range to start the next compare with
+    int         nranges;
+    monitor_range_t ranges[MONITOR_MAX_RANGES];
+    int         shadow_len;
+    uint8_t     shadow[MONITOR_SHADOW_SIZE];    // Watched bytes as last sent to the client
+    int         rxlen;
+    uint8_t     rx[MONITOR_RX_SIZE];            // Partial client frame
+    uint32_t    tx_oset;                        // Stream offset of the last segment sent
+    int         txlen;                          // Its length, 0 once acknowledged
+    uint8_t     tx[MONITOR_FRAME_LEN];          // Its copy, for retransmission
+} monitor_client_t;
+
+static monitor_client_t clients[MONITOR_MAX_CLIENTS];
+static uint8_t frame[MONITOR_FRAME_LEN];
+
+// Find the client of a socket, NULL if none. Clients whose connection has
+// been closed are released on the way
+//
+static monitor_client_t *monitor_find( int sock )
+{
+    monitor_client_t *found = NULL;
+
+    for ( int i = 0; i < MONITOR_MAX_CLIENTS; ++i )
+    {
+        monitor_client_t *mc = &clients[i];
+        NET_SOCKET *ts = &net_sockets[mc->sock];
+
+        if ( mc->active && ( ts->state != T_ESTABLISHED || ts->start_seq != mc->start_seq
+                                || ts->web_handler != monitor_handler ) )
+        {
+            mc->active = false;
+        }
+
+        if ( mc->active && mc->sock == sock )
+        {
+            found = mc;
+        }
+    }
+
+    return ( found );
+}
+
+static monitor_client_t *monitor_alloc( int sock )
+{
+    for ( int i = 0; i < MONITOR_MAX_CLIENTS; ++i )
+    {
+        monitor_client_t *mc = &clients[i];
+
+        if ( !mc->active )
+        {
+            memset( mc, 0, sizeof( monitor_client_t ) );
+            mc->active = true;
+            mc->sock = sock;
+            mc->start_seq = net_sockets[sock].start_seq;
+            mc->interval = MONITOR_INTERVAL_MS * 1000;
+            return ( mc );
+        }
+    }
+
+    return ( NULL );
+}
+
+// Keep a copy of the segment about to be sent, in case it has to be resent
+//
+static int monitor_keep( monitor_client_t *mc, NET_SOCKET *ts, uint32_t oset )
+{
+    mc->tx_oset = oset;
+    mc->txlen = ts->txdlen;
+    memcpy( mc->tx, &ts->txbuff[TCP_DATA_OFFSET], ts->txdlen );
+
+    return ( ts->txdlen );
+}
+
+static bool monitor_hex( const char *str, uint32_t max, uint32_t *value )
+{
+    char *end;
+
+    if ( !str )
+    {
+        return ( false );
+    }
+
+    *value = strtoul( str, &end, 16 );
+
+    return ( !*end && *value <= max );
+}
+
+static const char *monitor_watch( monitor_client_t *mc, const char *start, const char *count )
+{
+    uint32_t u_start, u_count;
+    monitor_range_t *mr;
+
+    if ( !monitor_hex( start, 0xFFFF, &u_start ) || !monitor_hex( count, MONITOR_SHADOW_SIZE, &u_count )
+            || !u_count || u_start + u_count > 0x10000 )
+    {
+        return ( "error: invalid range" );
+    }
+
+    if ( mc->nranges == MONITOR_MAX_RANGES || mc->shadow_len + u_count > MONITOR_SHADOW_SIZE )
+    {
+        return ( "error: too many watched addresses" );
+    }
+
+    mr = &mc->ranges[mc->nranges++];
+    mr->start = u_start;
+    mr->count = u_count;
+    mr->shadow = mc->shadow_len;
+    mr->synced = 0;
+    mc->shadow_len += u_count;
+
+    // Send the initial contents right away
+    //
+    mc->more = true;
+
+    return ( NULL );
+}
+
+static const char *monitor_unwatch( monitor_client_t *mc, const char *start )
+{
+    uint32_t u_start;
+    monitor_range_t *mr;
+    int i;
+
+    if ( !start )
+    {
+        mc->nranges = 0;
+        mc->shadow_len = 0;
+        return ( NULL );
+    }
+
+    if ( !monitor_hex( start, 0xFFFF, &u_start ) )
+    {
+        return ( "error: invalid address" );
+    }
+
+    for ( i = 0; i < mc->nranges && mc->ranges[i].start != u_start; ++i );
+
+    if ( i == mc->nranges )
+    {
+        return ( "error: address not watched" );
+    }
+
+    mr = &mc->ranges[i];
+
+    memmove( &mc->shadow[mr->shadow], &mc->shadow[mr->shadow + mr->count], mc->shadow_len - mr->shadow - mr->count );
+    mc->shadow_len -= mr->count;
+
+    for ( int j = 0; j < mc->nranges; ++j )
+    {
+        if ( mc->ranges[j].shadow > mr->shadow )
+        {
+            mc->ranges[j].shadow -= mr->count;
+        }
+    }
+
+    memmove( mr, mr + 1, ( mc->nranges - i - 1 ) * sizeof( monitor_range_t ) );
+    --mc->nranges;
+    mc->next = 0;
+
+    return ( NULL );
+}
+
+static const char *monitor_interval( monitor_client_t *mc, const char *ms )
+{
+    char *end;
+    uint32_t u_ms;
+
+    if ( !ms || ( u_ms = strtoul( ms, &end, 10 ), *end ) || u_ms < 10 || u_ms > 60000 )
+    {
+        return ( "error: invalid interval" );
+    }
+
+    mc->interval = u_ms * 1000;
+
+    return ( NULL );
+}
+
+// Text messages are commands, with hex addresses and counts:
+//
+//   watch START COUNT      Add a range to the watch list
+//   unwatch [START]        Remove the range at START, or all of them
+//   interval MS            Set the compare interval, 10 to 60000 ms
+//
+// Only errors are answered, with a text message
+//
+static void monitor_command( monitor_client_t *mc, int sock, uint8_t *payload, int len )
+{
+    char line[MONITOR_RX_SIZE];
+    char *command, *arg1, *arg2;
+    const char *error;
+
+    memcpy( line, payload, len );
+    line[len] = '\0';
+
+    command = strtok( line, " " );
+    arg1 = strtok( NULL, " " );
+    arg2 = strtok( NULL, " " );
+
+    if ( !command )
+    {
+        error = "error: empty command";
+    }
+    else if ( !strcmp( command, "watch" ) )
+    {
+        error = monitor_watch( mc, arg1, arg2 );
+    }
+    else if ( !strcmp( command, "unwatch" ) )
+    {
+        error = monitor_unwatch( mc, arg1 );
+    }
+    else if ( !strcmp( command, "interval" ) )
+    {
+        error = monitor_interval( mc, arg1 );
+    }
+    else
+    {
+        error = "error: unknown command";
+    }
+
+    if ( error )
+    {
+        websocket_add_frame( sock, WS_OP_TEXT, ( const uint8_t * )error, strlen( error ) );
+    }
+}
+
+// Process the frames received from the client. Returns false if the connection
+// is being closed
+//
+static bool monitor_rx( monitor_client_t *mc, int sock, uint8_t *data, int len )
+{
+    uint8_t *payload;
+    int n, opcode, plen;
+
+    while ( len > 0 )
+    {
+        n = MIN( len, MONITOR_RX_SIZE - mc->rxlen );
+        memcpy( &mc->rx[mc->rxlen], data, n );
+        mc->rxlen += n;
+        data += n;
+        len -= n;
+
+        while ( ( n = websocket_decode( mc->rx, mc->rxlen, &opcode, &payload, &plen ) ) > 0 )
+        {
+            switch ( opcode )
+            {
+                case WS_OP_TEXT:
+                    monitor_command( mc, sock, payload, plen );
+                    break;
+
+                case WS_OP_PING:
+                    websocket_add_frame( sock, WS_OP_PONG, payload, plen );
+                    break;
+
+                case WS_OP_CLOSE:
+                    websocket_add_close( sock, WS_CLOSE_NORMAL );
+                    tcp_sock_close( sock );
+                    return ( false );
+
+                default:
+                    break;
+            }
+
+            mc->rxlen -= n;
+            memmove( mc->rx, &mc->rx[n], mc->rxlen );
+        }
+
+        if ( n < 0 || mc->rxlen == MONITOR_RX_SIZE )
+        {
+            websocket_add_close( sock, n < 0 ? WS_CLOSE_PROTOCOL : WS_CLOSE_TOO_BIG );
+            tcp_sock_close( sock );
+            return ( false );
+        }
+    }
+
+    return ( true );
+}
+
+static inline bool monitor_changed( monitor_range_t *mr, uint8_t *shadow, int i )
+{
+    return ( i >= mr->synced || shadow[i] != ( uint8_t ) mem_map[mr->start + i] );
+}
+
+// Build a frame with the watched bytes that changed since they were last sent.
+// Unchanged gaps no longer than a record header are sent along, so the runs
+// at both sides are merged. If the frame fills up, the compare resumes on the
+// next call from the range where it stopped, so all get their turn.
+//
+// Returns the frame length
+//
+static int monitor_changes( monitor_client_t *mc, uint8_t *frame, int size )
+{
+    monitor_range_t *mr;
+    uint8_t *shadow;
+    int len = 0, r, i, j, last, gap;
+
+    mc->more = false;
+
+    for ( int k = 0; k < mc->nranges; ++k )
+    {
+        r = ( mc->next + k ) % mc->nranges;
+        mr = &mc->ranges[r];
+        shadow = &mc->shadow[mr->shadow];
+
+        for ( i = 0; i < mr->count; i = last + 1 )
+        {
+            last = i;
+
+            if ( !monitor_changed( mr, shadow, i ) )
+            {
+                continue;
+            }
+
+            if ( len + MONITOR_RECORD_LEN >= size )
+            {
+                mc->more = true;
+                mc->next = r;
+                return ( len );
+            }
+
+            for ( gap = 0, j = i + 1; j < mr->count && j - i < MONITOR_MAX_RUN && len + MONITOR_RECORD_LEN + j - i < size; ++j )
+            {
+                if ( monitor_changed( mr, shadow, j ) )
+                {
+                    last = j;
+                    gap = 0;
+                }
+                else if ( ++gap > MONITOR_RECORD_LEN )
+                {
+                    break;
+                }
+            }
+
+            frame[len++] = ( mr->start + i ) & 0xFF;
+            frame[len++] = ( mr->start + i ) >> 8;
+            frame[len++] = last - i + 1;
+
+            for ( j = i; j <= last; ++j )
+            {
+                frame[len++] = shadow[j] = ( uint8_t ) mem_map[mr->start + j];
+            }
+
+            if ( last >= mr->synced )
+            {
+                mr->synced = last + 1;
+            }
+        }
+    }
+
+    return ( len );
+}
+
+// Handler for GET /ramrom/monitor
+//
+// Live memory watch over a WebSocket. The client subscribes to address ranges
+// with text commands and gets binary frames with the bytes that changed, found
+// by comparing the ranges against a shadow copy every interval. The full
+// contents of a range are sent when subscribing to it.
+//
+int monitor_handler( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+    monitor_client_t *mc = monitor_find( sock );
+    uint32_t pos = ts->seq - ts->start_seq;     // Stream offset of the next byte to send
+    uint32_t now;
+    int len;
+
+    static http_request_t http_reqs[TCP_NUM_SOCKETS] = {0};
+    http_request_t *http_req = &http_reqs[sock];
+
+    if ( !mc )
+    {
+        if ( !req )
+        {
+            return ( 0 );
+        }
+
+        if ( httpd_init_http_request( http_req, ts, req, oset ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        if ( !( mc = monitor_alloc( sock ) ) )
+        {
+            return ( web_503_unavailable( sock ) );
+        }
+
+        if ( !websocket_accept( sock, http_req ) )
+        {
+            mc->active = false;
+            return ( web_400_bad_request( sock ) );
+        }
+
+        return ( monitor_keep( mc, ts, pos ) );
+    }
+
+    if ( req )
+    {
+        // Data is only taken once all that was sent has been acknowledged
+        //
+        mc->txlen = 0;
+        monitor_rx( mc, sock, ( uint8_t * )req, oset );
+
+        return ( monitor_keep( mc, ts, pos ) );
+    }
+
+    // The connection rewound to the last segment, it must be resent as it was
+    //
+    if ( mc->txlen && pos == mc->tx_oset )
+    {
+        return ( web_resp_add_data( sock, mc->tx, mc->txlen ) );
+    }
+
+    if ( ts->rx_ack != ts->seq )
+    {
+        return ( 0 );
+    }
+
+    mc->txlen = 0;
+
+    now = time_us_32();
+
+    if ( !mc->more && now - mc->last < mc->interval )
+    {
+        return ( 0 );
+    }
+
+    mc->last = now;
+
+    if ( !( len = monitor_changes( mc, frame, MONITOR_FRAME_LEN - WS_MAX_HEADER_LEN ) ) )
+    {
+        return ( 0 );
+    }
+
+    websocket_add_frame( sock, WS_OP_BINARY, frame, len );
+
+    return ( monitor_keep( mc, ts, pos ) );
+}
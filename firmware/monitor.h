@@ -0,0 +1,34 @@
+/*
+ * Live memory monitor for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#define MONITOR_MAX_CLIENTS 2           // Simultaneous WebSocket connections
+#define MONITOR_MAX_RANGES  8           // Watched ranges per connection
+#define MONITOR_SHADOW_SIZE 2048        // Watched bytes per connection
+#define MONITOR_RX_SIZE     128         // Largest frame accepted from clients
+#define MONITOR_INTERVAL_MS 50          // Default compare interval
+
+int monitor_handler( int sock, char *req, int oset );
+
+#endif /* MONITOR_H */
@@ -28,6 +28,7 @@
 #include "picowi_ioctl.h"
 #include "picowi_event.h"
 #include "picowi_ip.h"
+#include "picowi_net.h"
 
 extern int display_mode;
 IPADDR my_ip, bcast_ip=IPADDR_VAL(255,255,255,255);
@@ -59,9 +60,14 @@ void ip_set_mac(BYTE *mac)
 // Send transmit data
 int ip_tx_eth(BYTE *buff, int len)
 {
+    int ret;
+
     if (display_mode & DISP_ETH)
         ip_print_eth(buff);
-    return(event_net_tx(buff, len));
+    NET_TRACE(-1, NET_TRACE_SPI_START);
+    ret = event_net_tx(buff, len);
+    NET_TRACE(-1, NET_TRACE_SPI_END);
+    return(ret);
 }
 
 // Add Ethernet header to buffer, return byte count
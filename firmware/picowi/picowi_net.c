@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 // 18/05/2024 - Eduardo Casino - Configure country code
+// 17/10/2026 - Eduardo Casino - Add request tracing hook
 
 #include <stdio.h>
 #include <string.h>
@@ -43,6 +44,7 @@
 extern int display_mode;
 NET_SOCKET net_sockets[NUM_NET_SOCKETS];
 extern int accept_socket;
+net_trace_hook_t net_trace_hook;
 
 // Initialise the network stack
 int net_init(void)
@@ -240,4 +242,10 @@ NET_SOCKET *net_socket_ptr(int sock)
     return(&net_sockets[sock]);
 }
 
+// Set the request tracing hook, null to disable
+void net_set_trace_hook(net_trace_hook_t hook)
+{
+    net_trace_hook = hook;
+}
+
 // EOF
@@ -21,6 +21,9 @@
 // SOFTWARE.
 
 // 18/05/2024 - Eduardo Casino - Configure country code
+// 17/10/2026 - Eduardo Casino - Add request tracing hook
+// 17/10/2026 - Eduardo Casino - Add request parsing trace points
+// 17/10/2026 - Eduardo Casino - One more socket, for the telnet server
 
 #include <sys/types.h>
 
@@ -35,11 +38,34 @@ extern int dhcp_complete;
 #define SOCK_STREAM     1
 #define SOCK_DGRAM      2
 
-#define NUM_NET_SOCKETS 5
+#define NUM_NET_SOCKETS 6
 
 /* oset equals the request length when req != NULL */
 typedef int(*web_handler_t)(int sock, char *req, int oset);
 
+/* Trace points reported to the (optional) trace hook */
+typedef enum {
+    NET_TRACE_RX,               /* First segment of a new request */
+    NET_TRACE_PARSE_START,      /* Request line and headers parsing started */
+    NET_TRACE_PARSE_END,        /* Request line and headers parsing finished */
+    NET_TRACE_ROUTED,           /* Request matched a web handler */
+    NET_TRACE_HANDLER_START,    /* Web handler called */
+    NET_TRACE_HANDLER_END,      /* Web handler returned */
+    NET_TRACE_TCP_START,        /* TCP segment send started */
+    NET_TRACE_TCP_END,          /* TCP segment send finished */
+    NET_TRACE_SPI_START,        /* Frame transmit to the WiFi chip started */
+    NET_TRACE_SPI_END,          /* Frame transmit to the WiFi chip finished */
+    NET_TRACE_DONE,             /* Connection closed by either end */
+    NET_TRACE_ABORT,            /* Socket cleared before completion */
+    NET_TRACE_NUM_POINTS
+} net_trace_point_t;
+
+typedef void(*net_trace_hook_t)(int sock, net_trace_point_t point);
+
+extern net_trace_hook_t net_trace_hook;
+
+#define NET_TRACE(sock, point) do { if (net_trace_hook) net_trace_hook(sock, point); } while (0)
+
 #pragma pack(1)
 struct net_socket_t
 {
@@ -96,5 +122,6 @@ int accept(int server_sock, struct sockaddr *addr, socklen_t *addrlen);
 int recvfrom(int sock, void *mem, size_t len, int flags, struct sockaddr *from, socklen_t *fromlen);
 int sendto(int sock, void *data, size_t size, int flags, struct sockaddr *to, socklen_t tolen);
 NET_SOCKET *net_socket_ptr(int sock);
+void net_set_trace_hook(net_trace_hook_t hook);
 
 // EOF
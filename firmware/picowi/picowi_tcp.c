@@ -21,6 +21,8 @@
 // SOFTWARE.
 
 // 18/05/2024 - Eduardo Casino - Add support for large (multi-packet) HTTP requests
+// 17/10/2026 - Eduardo Casino - Add request tracing points
+// 17/10/2026 - Eduardo Casino - Add raw data handlers for server ports
 
 #include <stdio.h>
 #include <string.h>
@@ -48,6 +50,15 @@ char *tstate_strings[] = { TCP_STATE_STRS };
 extern NET_SOCKET net_sockets[NUM_NET_SOCKETS];
 int accept_socket = -1;
 
+// Server ports that carry raw data instead of HTTP requests
+typedef struct {
+    WORD port;
+    web_handler_t handler;
+} TCP_PORT_HANDLER;
+
+TCP_PORT_HANDLER tcp_port_handlers[MAX_TCP_PORT_HANDLERS];
+int num_tcp_port_handlers;
+
 int web_page_rx(int sock, char *req, int len);
 
 // Initialise TCP sockets
@@ -66,6 +77,28 @@ int tcp_sock_unused(void)
     return (-1);
 }
 
+// Set the handler for the data on a server port. It is called with the
+// received data, and with a null pointer to poll for data to send
+int tcp_port_handler(WORD port, web_handler_t handler)
+{
+    if (num_tcp_port_handlers >= MAX_TCP_PORT_HANDLERS)
+        return (0);
+    tcp_port_handlers[num_tcp_port_handlers].port = port;
+    tcp_port_handlers[num_tcp_port_handlers++].handler = handler;
+    return (1);
+}
+
+// Find the raw data handler for a server port, null if none
+web_handler_t tcp_find_port_handler(WORD port)
+{
+    for (int i = 0; i < num_tcp_port_handlers; i++)
+    {
+        if (tcp_port_handlers[i].port == port)
+            return (tcp_port_handlers[i].handler);
+    }
+    return (0);
+}
+
 // Set parameters in a TCP socket
 void tcp_sock_set(int sock, net_handler_t handler, IPADDR remip, WORD remport, WORD locport)
 {
@@ -202,6 +235,7 @@ int tcp_sock_rx(int sock, BYTE *data, int len)
         if ((rflags & TCP_ACK) && ts->rx_seq == ts->ack && ts->rx_ack == ts->seq)
         {
             ts->last_rx_ack = ts->ack;
+            ts->web_handler = tcp_find_port_handler(ts->loc_port);
             tcp_new_state(sock, T_ESTABLISHED);
         }
         else if (ustimeout(&ts->ticks, TCP_RETRY_USEC) && !tcp_sock_fail(sock))
@@ -232,9 +266,9 @@ int tcp_sock_rx(int sock, BYTE *data, int len)
             if (ts->rxdlen != 1)
                 ts->tries = 0;
             // Handle incoming data, put outgoing data in socket buffer
-            if (ts->rxdlen > 0 && ts->rx_seq == ts->ack)
+            if (ts->rxdlen > 0 && ts->rx_seq == ts->ack &&
+                tcp_get_resp(sock, &data[IP_DATA_OFFSET + hlen], ts->rxdlen) >= 0)
             {
-                tcp_get_resp(sock, &data[IP_DATA_OFFSET + hlen], ts->rxdlen);
                 ts->ack += ts->rxdlen;
             }
             // Remote closing of connection
@@ -291,8 +325,13 @@ int tcp_sock_rx(int sock, BYTE *data, int len)
         // Get more data to send
         else if (!ts->close && ts->web_handler)
         { 
+            int n;
+
             ts->txdlen = 0;
-            if (ts->web_handler(sock, 0, ts->seq - ts->start_seq) > 0)
+            NET_TRACE(sock, NET_TRACE_HANDLER_START);
+            n = ts->web_handler(sock, 0, ts->seq - ts->start_seq);
+            NET_TRACE(sock, NET_TRACE_HANDLER_END);
+            if (n > 0)
             {
                 tcp_sock_send(sock, TCP_ACK, 0, ts->txdlen);
                 ts->seq += ts->txdlen;
@@ -368,15 +407,23 @@ void tcp_sock_clear(int sock)
     WORD locport = ts->loc_port;
     int state = ts->state;
     
+    NET_TRACE(sock, NET_TRACE_ABORT);
     memset(ts, 0, sizeof(NET_SOCKET));
     ts->loc_port = locport;
     ts->state = state;
 }
 
-// Read in TCP request, get response into socket Tx buffer, return length
+// Read in TCP request, get response into socket Tx buffer. Raw data ports
+// can return -ve if the data can't be taken yet, so it is not acknowledged
+// and the remote sends it again
 int tcp_get_resp(int sock, BYTE *data, int dlen)
 {
-    return(web_page_rx(sock, (char *)data, dlen));
+    web_handler_t handler = tcp_find_port_handler(net_sockets[sock].loc_port);
+
+    if (handler)
+        return (handler(sock, (char *)data, dlen));
+    web_page_rx(sock, (char *)data, dlen);
+    return (0);
 }
 
 // Add Tx data to a TCP socket
@@ -399,6 +446,9 @@ void tcp_new_state(int sock, BYTE news)
     if ((display_mode & DISP_TCP_STATE) && ts->state < T_NUM_STATES && news < T_NUM_STATES)
         printf("TCP socket %u state %s -> %s\n", sock,
             tstate_strings[ts->state], tstate_strings[news]);
+    // Request is done when either end closes the connection
+    if (ts->state == T_ESTABLISHED && news != T_ESTABLISHED && news != T_FAILED)
+        NET_TRACE(sock, NET_TRACE_DONE);
     ts->state = news;
     ts->ticks = ustime();
 }
@@ -429,10 +479,14 @@ void tcp_sock_close(int sock)
 int tcp_sock_send(int sock, BYTE flags, void *data, int dlen)
 {
     NET_SOCKET *ts = &net_sockets[sock];
+    int ret;
 
     ts->ticks = (DWORD)ustime();
-    return(tcp_tx(sock, ts->txbuff, ts->rem_mac, ts->rem_ip, ts->rem_port, ts->loc_port,
-        ts->seq, ts->ack, flags, data, dlen));
+    NET_TRACE(sock, NET_TRACE_TCP_START);
+    ret = tcp_tx(sock, ts->txbuff, ts->rem_mac, ts->rem_ip, ts->rem_port, ts->loc_port,
+        ts->seq, ts->ack, flags, data, dlen);
+    NET_TRACE(sock, NET_TRACE_TCP_END);
+    return(ret);
 }
 
 // Send a TCP 'reset' to client
@@ -20,9 +20,12 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+// 17/10/2026 - Eduardo Casino - Add raw data handlers for server ports
+
 #pragma pack(1)
 
-#define TCP_NUM_SOCKETS 5
+#define TCP_NUM_SOCKETS 6
+#define MAX_TCP_PORT_HANDLERS 2
 
 #define TCP_MSS         1460
 #define TCP_WINDOW      (1 * TCP_MSS)
@@ -88,6 +91,8 @@ typedef struct tcph
 
 void tcp_init(void);
 int tcp_sock_unused(void);
+int tcp_port_handler(WORD port, web_handler_t handler);
+web_handler_t tcp_find_port_handler(WORD port);
 void tcp_sock_set(int sock, net_handler_t handler, IPADDR remip, WORD remport, WORD locport);
 int tcp_server_event_handler(EVENT_INFO *eip);
 int tcp_sock_match(IPADDR remip, WORD remport, WORD locport, BYTE flags);
@@ -22,9 +22,17 @@
 
 // 18/05/2024 - Eduardo Casino - Add support for POST/PUT/PATCH HTTP methods and
 //                               some HTTP error support functions
+// 17/10/2026 - Eduardo Casino - Add request tracing points
+// 17/10/2026 - Eduardo Casino - Keep track of multi-segment requests per socket
+// 17/10/2026 - Eduardo Casino - Resumable request parser, headers may span segments
+// 17/10/2026 - Eduardo Casino - Exact match routing with a sorted handler table
+// 17/10/2026 - Eduardo Casino - Connection upgrade, for WebSocket handlers
+// 17/10/2026 - Eduardo Casino - Add DELETE method
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include "picowi_defs.h"
 #include "picowi_ip.h"
 #include "picowi_net.h"
@@ -34,85 +42,329 @@
 int num_web_handlers;
 extern NET_SOCKET net_sockets[NUM_NET_SOCKETS];
 WEB_HANDLER web_handlers[MAX_WEB_HANDLERS];
+WEB_REQUEST web_requests[NUM_NET_SOCKETS];
 
 static WEB_METHOD web_methods[] = {
     { HTTP_GET,   "GET " },
     { HTTP_POST,  "POST " },
     { HTTP_PUT,   "PUT " },
     { HTTP_PATCH, "PATCH " },
+    { HTTP_DELETE, "DELETE " },
     { HTTP_UNSUPPORTED, "" }
 };
 
-// Set up a Web page handler
-int web_page_handler(web_method_t method, char *uri, web_handler_t handler)
+// Header names, lower case, in the order of web_header_t
+static const char *web_header_names[WEB_NUM_HEADERS] = {
+    "content-length", "range", "if-range", "if-none-match", "connection", "accept-encoding",
+    "upgrade", "sec-websocket-key"
+};
+
+// Compare a route URI with a request path of the given length, which is not
+// null-terminated, as strcmp() does
+static int web_path_cmp(const char *uri, const char *path, int len)
+{
+    int n = strncmp(uri, path, len);
+
+    return (n ? n : (unsigned char)uri[len]);
+}
+
+// Match a request path with a route URI with {name} segments, storing the
+// value of each one in the request. Returns 0 if they don't match
+static int web_path_match(const char *uri, const char *path, int len, WEB_REQUEST *wr)
 {
-    if (num_web_handlers < MAX_WEB_HANDLERS)
+    const char *end = path + len;
+    int n = 0, vlen;
+
+    while (*uri && path < end)
     {
-        web_handlers[num_web_handlers].method = method;
-        web_handlers[num_web_handlers].uri = uri;
-        web_handlers[num_web_handlers++].handler = handler;
-        return (1);
+        if (*uri == '{')
+        {
+            if (n == MAX_WEB_PATH_PARAMS || !(uri = strchr(uri, '}')))
+                return (0);
+            uri++;
+            for (vlen = 0; path < end && *path != '/'; vlen++)
+            {
+                if (vlen == MAX_WEB_PARAM_LEN - 1)
+                    return (0);
+                wr->params[n][vlen] = *path++;
+            }
+            if (!vlen)
+                return (0);
+            wr->params[n++][vlen] = 0;
+        }
+        else if (*uri++ != *path++)
+            return (0);
     }
-    return (0);
-}    
+    return (!*uri && path == end);
+}
 
-// Handle a Web page request, return length of response
-int web_page_rx(int sock, char *req, int len)
+// Find the first handler of the route for a request path, -1 if none.
+// Exact paths are looked up with a binary search in the sorted table, and
+// the routes with {name} segments, if any, are tried next
+static int web_find_route(WEB_REQUEST *wr, const char *path, int len)
 {
-    static int lastseq = -1;
-    int i, n, found = 0;
-    WEB_METHOD *wm=web_methods;
-    WEB_HANDLER *whp=web_handlers;
-    NET_SOCKET *ts = &net_sockets[sock];
-    web_method_t method;
-    char *uri;
+    int lo = 0, hi = num_web_handlers, mid;
 
-    if ( lastseq == ts->seq )
+    while (lo < hi)
     {
-        return (ts->web_handler(sock, req, len));
+        mid = (lo + hi) / 2;
+        if (web_path_cmp(web_handlers[mid].uri, path, len) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
-    
-    lastseq = ts->seq;
+    if (lo < num_web_handlers && !web_path_cmp(web_handlers[lo].uri, path, len))
+        return (lo);
+
+    for (lo = 0; lo < num_web_handlers; lo++)
+    {
+        if (web_handlers[lo].params && web_path_match(web_handlers[lo].uri, path, len, wr))
+            return (lo);
+    }
+    return (-1);
+}
+
+// Set up a Web page handler. The table is kept sorted by URI and method, so
+// registration order does not matter and the handlers of a route are adjacent
+int web_page_handler(web_method_t method, char *uri, web_handler_t handler)
+{
+    int i, n;
 
-    uri = strchr(req, '/' );
+    if (num_web_handlers >= MAX_WEB_HANDLERS)
+        return (0);
+
+    for (i = num_web_handlers; i > 0; i--)
+    {
+        n = strcmp(web_handlers[i-1].uri, uri);
+        if (n < 0 || (!n && web_handlers[i-1].method <= method))
+            break;
+        web_handlers[i] = web_handlers[i-1];
+    }
+    web_handlers[i].method = method;
+    web_handlers[i].uri = uri;
+    web_handlers[i].handler = handler;
+    for (n = 0; *uri; )
+        n += *uri++ == '{';
+    web_handlers[i].params = n;
+    num_web_handlers++;
+    return (1);
+}
+
+// Call a Web page handler, reporting it to the trace hook
+static int web_call_handler(int sock, web_handler_t handler, char *req, int len)
+{
+    int n;
+
+    NET_TRACE(sock, NET_TRACE_HANDLER_START);
+    n = handler(sock, req, len);
+    NET_TRACE(sock, NET_TRACE_HANDLER_END);
+    return (n);
+}
+
+// Find method of request
+static web_method_t web_find_method(char *method_str)
+{
+    WEB_METHOD *wm=web_methods;
 
-    /* Find method of request*/
     for (; wm->method != HTTP_UNSUPPORTED; wm++)
     {
-        n = strlen(wm->method_str);
-        if (!memcmp(wm->method_str, req, n))
+        if (!strncmp(wm->method_str, method_str, strlen(method_str)) &&
+            wm->method_str[strlen(method_str)] == ' ')
         {
             break;
         }
     }
-    method = wm->method;
+    return (wm->method);
+}
+
+// Find header to keep, -1 if it must be discarded
+static int web_find_header(char *name)
+{
+    int i;
 
-    if (method == HTTP_UNSUPPORTED)
+    for (i = 0; i < WEB_NUM_HEADERS; i++)
     {
-        return web_405_method_not_allowed(sock);        
+        if (!strcmp(web_header_names[i], name))
+            return (i);
     }
+    return (-1);
+}
+
+// Feed request data to the parser, in a single pass. Returns the number of
+// bytes consumed when the headers are complete, so the rest is body data,
+// -1 if more data is needed or -2 if the request is malformed
+int web_parse(WEB_REQUEST *wr, char *data, int len)
+{
+    int i;
+    char c;
 
-    for (i = 0; i < MAX_WEB_HANDLERS; i++, whp++)
+    for (i = 0; i < len; i++)
     {
-        if (whp->uri && whp->handler)
+        c = data[i];
+
+        switch (wr->state)
         {
-            n = strlen(whp->uri);
-            if (!memcmp(whp->uri, uri, n))
+        case WEB_PARSE_METHOD:
+            if (c == ' ' && wr->len)
+            {
+                wr->method_str[wr->len] = 0;
+                wr->method = web_find_method(wr->method_str);
+                wr->state = WEB_PARSE_URI;
+                wr->len = 0;
+            }
+            else if (c < 'A' || c > 'Z' || wr->len >= sizeof(wr->method_str) - 1)
+                return (-2);
+            else
+                wr->method_str[wr->len++] = c;
+            break;
+
+        case WEB_PARSE_URI:
+            if (c == ' ' && wr->len)
+            {
+                wr->uri[wr->len] = 0;
+                wr->state = WEB_PARSE_VERSION;
+            }
+            else if (c <= ' ' || wr->len >= MAX_WEB_URI_LEN - 1)
+                return (-2);
+            else
+                wr->uri[wr->len++] = c;
+            break;
+
+        case WEB_PARSE_VERSION:
+            if (c == '\n')
             {
-                ++found;
-                if (whp->method == method)
+                wr->state = WEB_PARSE_NAME;
+                wr->len = 0;
+            }
+            break;
+
+        case WEB_PARSE_NAME:
+            if (c == '\n')
+            {
+                // A line without a colon is only valid if empty, the end of the headers
+                if (wr->len)
+                    return (-2);
+                wr->state = WEB_PARSE_DONE;
+                wr->content_len = atoi(wr->headers[WEB_HDR_CONTENT_LENGTH]);
+                return (i + 1);
+            }
+            else if (c == ':')
+            {
+                // Names too long are not any of ours
+                wr->header = -1;
+                if (wr->len < MAX_WEB_NAME_LEN)
+                {
+                    wr->name[wr->len] = 0;
+                    wr->header = web_find_header(wr->name);
+                }
+                wr->state = WEB_PARSE_VALUE_WS;
+                wr->len = 0;
+            }
+            else if (c != '\r')
+            {
+                if (wr->len < MAX_WEB_NAME_LEN - 1)
+                    wr->name[wr->len] = tolower((unsigned char)c);
+                if (wr->len < MAX_WEB_NAME_LEN)
+                    wr->len++;
+            }
+            break;
+
+        case WEB_PARSE_VALUE_WS:
+            if (c == ' ' || c == '\t')
+                break;
+            wr->state = WEB_PARSE_VALUE;
+            // Fall through
+
+        case WEB_PARSE_VALUE:
+            if (c == '\n')
+            {
+                if (wr->header >= 0)
                 {
-                    ts->web_handler = whp->handler;
-                    return (whp->handler(sock, req, len));
+                    while (wr->len && wr->headers[wr->header][wr->len - 1] == ' ')
+                        wr->len--;
+                    wr->headers[wr->header][wr->len] = 0;
                 }
+                wr->state = WEB_PARSE_NAME;
+                wr->len = 0;
             }
+            else if (c != '\r' && wr->header >= 0 && wr->len < MAX_WEB_VAL_LEN - 1)
+                wr->headers[wr->header][wr->len++] = c;
+            break;
+
+        default:
+            return (i);
         }
     }
+    return (-1);
+}
+
+// Handle a Web page request, return length of response
+int web_page_rx(int sock, char *req, int len)
+{
+    static int lastseq[NUM_NET_SOCKETS] = { [0 ... NUM_NET_SOCKETS-1] = -1 };
+    int i, n, route;
+    NET_SOCKET *ts = &net_sockets[sock];
+    WEB_REQUEST *wr = &web_requests[sock];
 
-    if (found)
-        return (web_405_method_not_allowed(sock));
+    // Upgraded connection, no more HTTP requests on it
+    if (wr->state == WEB_PARSE_UPGRADED && ts->web_handler)
+        return (web_call_handler(sock, ts->web_handler, req, len));
+
+    if ( lastseq[sock] == ts->seq )
+    {
+        // Body data of a request already routed
+        if (wr->state == WEB_PARSE_DONE)
+            return (web_call_handler(sock, ts->web_handler, req, len));
+    }
     else
+    {
+        lastseq[sock] = ts->seq;
+        memset(wr, 0, sizeof(WEB_REQUEST));
+        // Not routed yet, so no handler must be polled for Tx data
+        ts->web_handler = 0;
+        NET_TRACE(sock, NET_TRACE_RX);
+    }
+
+    NET_TRACE(sock, NET_TRACE_PARSE_START);
+    n = web_parse(wr, req, len);
+    NET_TRACE(sock, NET_TRACE_PARSE_END);
+
+    // Wait for the rest of the headers
+    if (n == -1)
+        return (0);
+
+    if (n < 0)
+        return (web_400_bad_request(sock));
+
+    printf("\nTCP socket %d Rx %s %s\n", sock, wr->method_str, wr->uri);
+
+    if (wr->method == HTTP_UNSUPPORTED)
+    {
+        return web_405_method_not_allowed(sock);        
+    }
+
+    // The path is matched exactly, without the query string
+    if ((route = web_find_route(wr, wr->uri, strcspn(wr->uri, "?"))) < 0)
         return (web_404_not_found(sock));
+
+    for (i = route; i < num_web_handlers && !strcmp(web_handlers[i].uri, web_handlers[route].uri); i++)
+    {
+        if (web_handlers[i].method == wr->method)
+        {
+            ts->web_handler = web_handlers[i].handler;
+            NET_TRACE(sock, NET_TRACE_ROUTED);
+            return (web_call_handler(sock, web_handlers[i].handler, &req[n], len - n));
+        }
+    }
+    return (web_405_method_not_allowed(sock));
+}
+
+// Switch the connection to another protocol, after the handler has accepted
+// the upgrade. All data received from now on is passed to the handler
+int web_upgrade(int sock)
+{
+    web_requests[sock].state = WEB_PARSE_UPGRADED;
+    return (1);
 }
 
 // Add data to an HTTP response
@@ -183,4 +435,17 @@ int web_405_method_not_allowed(int sock)
     
     return (n);
 }
+
+// Send a "503 Service Unavailable" response
+int web_503_unavailable(int sock)
+{
+    int n;
+
+    n = web_resp_add_str(sock, HTTP_503_FAIL HTTP_SERVER HTTP_NOCACHE);
+    n += web_resp_add_content_len(sock, 0);
+    n += web_resp_add_str(sock, HTTP_CONNECTION_CLOSE HTTP_HEADER_END);
+    tcp_sock_close(sock);
+    
+    return (n);
+}
 // EOF
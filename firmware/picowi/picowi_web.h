@@ -22,43 +22,111 @@
 
 // 18/05/2024 - Eduardo Casino - Add support for POST/PUT/PATCH HTTP methods and
 //                               some HTTP error support functions
+// 17/10/2026 - Eduardo Casino - Add request tracing support
+// 17/10/2026 - Eduardo Casino - Add conditional and range request definitions
+// 17/10/2026 - Eduardo Casino - Add resumable request parser
+// 17/10/2026 - Eduardo Casino - Add sorted route table with path parameters
+// 17/10/2026 - Eduardo Casino - Add connection upgrade support
+// 17/10/2026 - Eduardo Casino - Add DELETE method
 
-#define MAX_WEB_HANDLERS 10
+#define MAX_WEB_HANDLERS 48
+#define MAX_WEB_URI_LEN  96
+#define MAX_WEB_NAME_LEN 20     /* Longest header name we care about, plus terminator */
+#define MAX_WEB_VAL_LEN  40
+#define MAX_WEB_PATH_PARAMS 2   /* {name} segments in a route URI */
+#define MAX_WEB_PARAM_LEN   24
 
+#define HTTP_101_SWITCHING  "HTTP/1.1 101 Switching Protocols\r\n"
 #define HTTP_200_OK         "HTTP/1.1 200 OK\r\n"
+#define HTTP_206_PARTIAL    "HTTP/1.1 206 Partial Content\r\n"
+#define HTTP_304_NOT_MODIFIED "HTTP/1.1 304 Not Modified\r\n"
 #define HTTP_400_FAIL       "HTTP/1.1 400 Bad request\r\n"
 #define HTTP_404_FAIL       "HTTP/1.1 404 Not Found\r\n"
 #define HTTP_405_FAIL       "HTTP/1.1 405 Method Not Allowed\r\n"
+#define HTTP_416_FAIL       "HTTP/1.1 416 Range Not Satisfiable\r\n"
+#define HTTP_503_FAIL       "HTTP/1.1 503 Service Unavailable\r\n"
 #define HTTP_SERVER         "Server: picowi\r\n"
 #define HTTP_NOCACHE        "Cache-Control: no-cache, no-store, must-revalidate\r\n"
+#define HTTP_REVALIDATE     "Cache-Control: no-cache\r\n"
+#define HTTP_ACCEPT_RANGES  "Accept-Ranges: bytes\r\n"
+#define HTTP_ETAG           "ETag: \"%08lx\"\r\n"
+#define HTTP_CONTENT_RANGE  "Content-Range: bytes %d-%d/%d\r\n"
+#define HTTP_RANGE_UNSATISFIED "Content-Range: bytes */%d\r\n"
 #define HTTP_CONTENT_HTML   "Content-Type: text/html; charset=ISO-8859-1\r\n"
 #define HTTP_CONTENT_JPEG   "Content-Type: image/jpeg\r\n"
 #define HTTP_CONTENT_TEXT   "Content-Type: text/plain\r\n"
 #define HTTP_CONTENT_BINARY "Content-Type: application/octet-stream\r\n"
+#define HTTP_CONTENT_JSON   "Content-Type: application/json\r\n"
 #define HTTP_CONTENT_LENGTH "Content-Length: %d\r\n"
 #define HTTP_ORIGIN_ANY     "Access-Control-Allow-Origin: *\r\n"
 #define HTTP_TRANSFER_CHUNKED "Transfer-Encoding: chunked\r\n"
 #define HTTP_MULTIPART      "Content-Type: multipart/x-mixed-replace; boundary=mjpeg_boundary\r\n"
 #define HTTP_BOUNDARY       "\r\n--mjpeg_boundary\r\n"
 #define HTTP_CONNECTION_CLOSE "Connection: close\r\n"
+#define HTTP_CONNECTION_UPGRADE "Connection: Upgrade\r\n"
 #define HTTP_HEADER_END     "\r\n"
 
 /* Supported methods */
-typedef enum { HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_UNSUPPORTED } web_method_t;
+typedef enum { HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_UNSUPPORTED } web_method_t;
 
 typedef struct {
     web_method_t method;
-    char method_str[7];     /* Should be expanded if longer methods are added */
+    char method_str[8];     /* Should be expanded if longer methods are added */
 } WEB_METHOD;
 
 typedef struct {
     web_method_t method;
     char *uri;
     web_handler_t handler;
+    int params;                             /* Number of {name} segments in the URI */
 } WEB_HANDLER;
 
+/* Headers kept by the request parser, the rest are discarded */
+typedef enum {
+    WEB_HDR_CONTENT_LENGTH,
+    WEB_HDR_RANGE,
+    WEB_HDR_IF_RANGE,
+    WEB_HDR_IF_NONE_MATCH,
+    WEB_HDR_CONNECTION,
+    WEB_HDR_ACCEPT_ENCODING,
+    WEB_HDR_UPGRADE,
+    WEB_HDR_SEC_WEBSOCKET_KEY,
+    WEB_NUM_HEADERS
+} web_header_t;
+
+typedef enum {
+    WEB_PARSE_METHOD,
+    WEB_PARSE_URI,
+    WEB_PARSE_VERSION,
+    WEB_PARSE_NAME,
+    WEB_PARSE_VALUE_WS,
+    WEB_PARSE_VALUE,
+    WEB_PARSE_DONE,
+    WEB_PARSE_UPGRADED                      /* Switched protocols, data goes straight to the handler */
+} web_parse_state_t;
+
+/* Per socket request parser state. Survives across segments, so the request
+   line and headers can be split anywhere */
+typedef struct {
+    web_parse_state_t state;
+    web_method_t method;
+    int len;                                /* Length of the token being parsed */
+    int header;                             /* Header being stored, -1 if discarded */
+    int content_len;
+    char method_str[8];
+    char uri[MAX_WEB_URI_LEN];
+    char name[MAX_WEB_NAME_LEN];
+    char headers[WEB_NUM_HEADERS][MAX_WEB_VAL_LEN];
+    char params[MAX_WEB_PATH_PARAMS][MAX_WEB_PARAM_LEN];  /* Values of the {name} segments */
+} WEB_REQUEST;
+
+extern WEB_HANDLER web_handlers[MAX_WEB_HANDLERS];
+extern WEB_REQUEST web_requests[NUM_NET_SOCKETS];
+
 int web_page_handler(web_method_t method, char *uri, web_handler_t handler);
 int web_page_rx(int sock, char *req, int len);
+int web_upgrade(int sock);
+int web_parse(WEB_REQUEST *wr, char *data, int len);
 int web_resp_add_data(int sock, BYTE *data, int dlen);
 int web_resp_add_str(int sock, char *str);
 int web_resp_add_content_len(int sock, int n);
@@ -66,5 +134,6 @@ int web_resp_send(int sock);
 int web_400_bad_request(int sock);
 int web_404_not_found(int sock);
 int web_405_method_not_allowed(int sock);
+int web_503_unavailable(int sock);
 
 // EOF
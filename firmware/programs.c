@@ -0,0 +1,307 @@
+/*
+ * Program library and loader for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "config.h"
+#include "devices.h"
+#include "library.h"
+#include "programs.h"
+
+// KIM-1 monitor locations, for the tape load patch
+//
+#define KIM_POINTL          0xFA        // Address shown on the display
+#define KIM_POINTH          0xFB
+#define KIM_ID              0x17F9      // ID of the program to load
+#define KIM_LOADT           0x1873      // Tape load entry
+#define KIM_START           0x1C4F      // Monitor entry
+
+static inline volatile uint8_t *programs_byte( uint32_t address )
+{
+    return ( volatile uint8_t * )&mem_map[address];
+}
+
+// The catalog is read in place. It is only changed from core 0, and core 1
+// is paused while the flash is written
+//
+static inline const program_t *programs_catalog( void )
+{
+    return ( const program_t * )library_page( PROGRAMS_CATALOG_PAGE );
+}
+
+static inline int programs_pages( uint32_t length )
+{
+    return ( ( length + LIBRARY_PAGE_SIZE - 1 ) / LIBRARY_PAGE_SIZE );
+}
+
+static int programs_index( const program_t *catalog, uint8_t id )
+{
+    for ( int i = 0; i < PROGRAMS_MAX; ++i )
+    {
+        if ( catalog[i].id == id )
+        {
+            return ( i );
+        }
+    }
+
+    return ( -1 );
+}
+
+static bool programs_page_used( const program_t *catalog, int page )
+{
+    for ( int i = 0; i < PROGRAMS_MAX; ++i )
+    {
+        if ( catalog[i].id != PROGRAMS_FREE_ID
+            && page >= catalog[i].page && page < catalog[i].page + programs_pages( catalog[i].length ) )
+        {
+            return ( true );
+        }
+    }
+
+    return ( false );
+}
+
+static bool programs_save( const program_t *catalog )
+{
+    return ( library_erase( PROGRAMS_CATALOG_PAGE )
+            && library_program( PROGRAMS_CATALOG_PAGE, 0, ( const uint8_t * )catalog, LIBRARY_CHUNK_SIZE ) );
+}
+
+static bool programs_valid( uint8_t id, uint32_t address, uint32_t length )
+{
+    return ( id && id != PROGRAMS_FREE_ID && length && address + length <= PROGRAMS_MAX_LEN );
+}
+
+const program_t *programs_find( uint8_t id )
+{
+    const program_t *catalog = programs_catalog();
+    int i;
+
+    if ( id == PROGRAMS_FREE_ID || ( i = programs_index( catalog, id ) ) < 0 )
+    {
+        return ( NULL );
+    }
+
+    return ( &catalog[i] );
+}
+
+// Find room for a new program. A program with the same ID is kept until the
+// new one is committed, so a failed upload does not lose it, and its pages
+// are not reused. Returns the first page of the image, which must then be
+// written to the library, or -1 if the program does not fit. The pages are
+// not reserved, so there must be a single upload at a time
+//
+int programs_begin( uint8_t id, uint32_t address, uint32_t length )
+{
+    const program_t *catalog = programs_catalog();
+    int pages = programs_pages( length );
+    int i;
+
+    if ( !programs_valid( id, address, length )
+        || ( programs_index( catalog, id ) < 0 && programs_index( catalog, PROGRAMS_FREE_ID ) < 0 ) )
+    {
+        return ( -1 );
+    }
+
+    for ( int page = PROGRAMS_FIRST_PAGE; page + pages <= LIBRARY_NUM_PAGES; ++page )
+    {
+        for ( i = 0; i < pages && !programs_page_used( catalog, page + i ); ++i )
+            ;
+
+        if ( i == pages )
+        {
+            return ( page );
+        }
+    }
+
+    return ( -1 );
+}
+
+// Add the program to the catalog, once its image is in the library. It
+// replaces the program with the same ID, whose pages are then free
+//
+bool programs_commit( uint8_t id, uint32_t address, uint32_t length, int page )
+{
+    program_t catalog[PROGRAMS_MAX];
+    int i;
+
+    memcpy( catalog, programs_catalog(), sizeof( catalog ) );
+
+    if ( !programs_valid( id, address, length )
+        || ( ( i = programs_index( catalog, id ) ) < 0 && ( i = programs_index( catalog, PROGRAMS_FREE_ID ) ) < 0 ) )
+    {
+        return ( false );
+    }
+
+    catalog[i] = ( program_t ) { .id = id, .page = page, .address = address, .length = length };
+
+    return ( programs_save( catalog ) );
+}
+
+// Remove the program from the catalog. Its pages are reused by the next
+// programs added
+//
+bool programs_delete( uint8_t id )
+{
+    program_t catalog[PROGRAMS_MAX];
+    int i;
+
+    memcpy( catalog, programs_catalog(), sizeof( catalog ) );
+
+    if ( id == PROGRAMS_FREE_ID || ( i = programs_index( catalog, id ) ) < 0 )
+    {
+        return ( false );
+    }
+
+    catalog[i].id = PROGRAMS_FREE_ID;
+
+    return ( programs_save( catalog ) );
+}
+
+// Replace the tape load routine of the monitor in the memory map with a
+// call to the loader device, which must be mapped. It loads the program
+// with the ID at $17F9, and shows 0000 on success or FFFF if the program
+// is not in the library, as the monitor does after a tape load
+//
+bool programs_patch_monitor( void )
+{
+    int32_t base = devices_base( devices_find( "loader" ) );
+    uint16_t id = base + LOADER_ID, cmd = base + LOADER_CMD;
+
+    const uint8_t patch[] = {
+        0xAD, KIM_ID & 0xFF, KIM_ID >> 8,           //          LDA ID
+        0x8D, id & 0xFF, id >> 8,                   //          STA LOADER_ID
+        0xA9, LOADER_LOAD,                          //          LDA #LOADER_LOAD
+        0x8D, cmd & 0xFF, cmd >> 8,                 //          STA LOADER_CMD
+        0xAD, cmd & 0xFF, cmd >> 8,                 // WAIT:    LDA LOADER_CMD
+        0x30, 0xFB,                                 //          BMI WAIT
+        0xF0, 0x02,                                 //          BEQ DONE
+        0xA9, 0xFF,                                 //          LDA #$FF
+        0x85, KIM_POINTL,                           // DONE:    STA POINTL
+        0x85, KIM_POINTH,                           //          STA POINTH
+        0x4C, KIM_START & 0xFF, KIM_START >> 8      //          JMP START
+    };
+
+    if ( base < 0 )
+    {
+        return ( false );
+    }
+
+    for ( int i = 0; i < sizeof( patch ); ++i )
+    {
+        if ( ( mem_map[KIM_LOADT + i] & MEM_ATTR_CE_MASK ) != MEM_ATTR_ENABLED )
+        {
+            return ( false );
+        }
+    }
+
+    for ( int i = 0; i < sizeof( patch ); ++i )
+    {
+        *programs_byte( KIM_LOADT + i ) = patch[i];
+    }
+
+    return ( true );
+}
+
+// Catalog as JSON. Returns the length, or -1 if it does not fit
+//
+int programs_json( char *buf, int size )
+{
+    const program_t *catalog = programs_catalog();
+    int n = 0;
+
+#define PROGRAMS_ADD( expr ) do { n += ( expr ); if ( n >= size ) return -1; } while ( 0 )
+#define PROGRAMS_PUT( ... ) PROGRAMS_ADD( snprintf( &buf[n], size - n, __VA_ARGS__ ) )
+
+    PROGRAMS_PUT( "[" );
+
+    for ( int i = 0; i < PROGRAMS_MAX; ++i )
+    {
+        if ( catalog[i].id != PROGRAMS_FREE_ID )
+        {
+            PROGRAMS_PUT( "%s{\"id\":\"%02x\",\"address\":\"%04x\",\"length\":%lu}", n > 1 ? "," : "",
+                          catalog[i].id, catalog[i].address, ( unsigned long ) catalog[i].length );
+        }
+    }
+
+    PROGRAMS_PUT( "]" );
+
+#undef PROGRAMS_PUT
+#undef PROGRAMS_ADD
+
+    return ( n );
+}
+
+// Called from core 1 on each 6502 write to the loader registers. The load
+// command copies the program image from the library into the memory map,
+// and replaces the command with the status, so the 6502 sees it busy until
+// the program is in place.
+//
+// As with a tape load, only enabled RAM is written. The image is copied by
+// the CPU, as DMA can't skip the attribute bytes of the memory map
+//
+void programs_write( uint16_t base, int reg, uint8_t value )
+{
+    const program_t *program;
+    const uint8_t *src;
+    uint8_t status = LOADER_DONE;
+
+    if ( reg != LOADER_CMD )
+    {
+        return;
+    }
+
+    if ( value != LOADER_LOAD )
+    {
+        status = LOADER_ERROR;
+    }
+    else if ( !( program = programs_find( *programs_byte( base + LOADER_ID ) ) ) )
+    {
+        status = LOADER_NOT_FOUND;
+    }
+    else
+    {
+        src = library_page( program->page );
+
+        for ( uint32_t i = 0; i < program->length; ++i )
+        {
+            uint32_t address = program->address + i;
+
+            if ( ( mem_map[address] & MEM_ATTR_MASK ) == ( MEM_ATTR_ENABLED | MEM_ATTR_WRITEABLE ) )
+            {
+                *programs_byte( address ) = src[i];
+            }
+        }
+
+        *programs_byte( base + LOADER_ADDR ) = program->address & 0xFF;
+        *programs_byte( base + LOADER_ADDR + 1 ) = program->address >> 8;
+        *programs_byte( base + LOADER_LEN ) = program->length & 0xFF;
+        *programs_byte( base + LOADER_LEN + 1 ) = ( program->length >> 8 ) & 0xFF;
+    }
+
+    // The program must be in place before the 6502 sees the status
+    //
+    __sync_synchronize();
+    *programs_byte( base + LOADER_CMD ) = status;
+}
@@ -0,0 +1,74 @@
+/*
+ * Program library and loader for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef PROGRAMS_H
+#define PROGRAMS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "library.h"
+
+// The program library takes the library pages after the ROM images. The
+// first one holds the catalog, and the program images are stored in the
+// rest, each one in consecutive pages
+//
+#define PROGRAMS_CATALOG_PAGE   LIBRARY_ROM_PAGES
+#define PROGRAMS_FIRST_PAGE     ( LIBRARY_ROM_PAGES + 1 )
+#define PROGRAMS_MAX            ( LIBRARY_CHUNK_SIZE / sizeof( program_t ) )
+#define PROGRAMS_MAX_LEN        0x10000
+
+// Catalog entry. Erased flash reads as free entries
+//
+typedef struct {
+    uint8_t         id;                 // KIM-1 tape ID, 01 to FE
+    uint8_t         page;               // First library page of the image
+    uint16_t        address;            // Load address
+    uint32_t        length;
+} program_t;
+
+#define PROGRAMS_FREE_ID        0xFF
+
+// Loader registers, from the device base address. The address and the
+// length of the loaded program are little endian
+//
+#define LOADER_ID               0       // Program to load
+#define LOADER_CMD              1       // Write a command to start
+#define LOADER_ADDR             2       // Load address, set by the card
+#define LOADER_LEN              4       // Length, set by the card. 0 for 64K
+#define LOADER_NUM_REGS         6
+
+#define LOADER_LOAD             0x80    // Command
+
+#define LOADER_DONE             0x00    // Status values, replace the command when done
+#define LOADER_NOT_FOUND        0x01    // No program with that ID
+#define LOADER_ERROR            0xFF    // Unknown command
+
+const program_t *programs_find( uint8_t id );
+int programs_begin( uint8_t id, uint32_t address, uint32_t length );
+bool programs_commit( uint8_t id, uint32_t address, uint32_t length, int page );
+bool programs_delete( uint8_t id );
+bool programs_patch_monitor( void );
+int programs_json( char *buf, int size );
+void programs_write( uint16_t base, int reg, uint8_t value );
+
+#endif /* PROGRAMS_H */
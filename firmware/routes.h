@@ -0,0 +1,74 @@
+/*
+ * Configuration web server for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+/*
+ * Web API route list. Each entry expands the ROUTE( method, uri, handler )
+ * macro defined by the includer, which builds the route table from it.
+ *
+ * URIs are matched exactly against the request path, without the query
+ * string, so entries can be listed in any order. A "{name}" segment matches
+ * any single path segment, and its value is passed to the handler in the
+ * path_params of the request.
+ */
+
+//     Method       URI                      Handler
+ROUTE( HTTP_GET,    "/ramrom/range",         handle_ramrom_get )
+ROUTE( HTTP_PATCH,  "/ramrom/range",         handle_ramrom_patch )
+ROUTE( HTTP_PATCH,  "/ramrom/range/data",    handle_ramrom_data_patch )
+ROUTE( HTTP_PATCH,  "/ramrom/range/enable",  handle_ramrom_enable_patch )
+ROUTE( HTTP_PATCH,  "/ramrom/range/disable", handle_ramrom_disable_patch )
+ROUTE( HTTP_PATCH,  "/ramrom/range/setrom",  handle_ramrom_setrom_patch )
+ROUTE( HTTP_PATCH,  "/ramrom/range/setram",  handle_ramrom_setram_patch )
+ROUTE( HTTP_PUT,    "/ramrom/restore",       handle_restore_put )
+ROUTE( HTTP_PUT,    "/ramrom/video",         handle_video_put )
+ROUTE( HTTP_GET,    "/ramrom/monitor",       monitor_handler )
+ROUTE( HTTP_GET,    "/system/trace",         handle_trace_get )
+ROUTE( HTTP_PUT,    "/system/trace",         handle_trace_put )
+ROUTE( HTTP_GET,    "/mailbox",              handle_mailbox_get )
+ROUTE( HTTP_POST,   "/mailbox",              handle_mailbox_post )
+ROUTE( HTTP_PUT,    "/mailbox",              handle_mailbox_put )
+ROUTE( HTTP_GET,    "/devices",              handle_devices_get )
+ROUTE( HTTP_PUT,    "/devices/{name}",       handle_devices_put )
+ROUTE( HTTP_DELETE, "/devices/{name}",       handle_devices_delete )
+ROUTE( HTTP_GET,    "/library",              handle_library_get )
+ROUTE( HTTP_GET,    "/library/{page}",       handle_library_page_get )
+ROUTE( HTTP_PUT,    "/library/{page}",       handle_library_page_put )
+ROUTE( HTTP_DELETE, "/library/{page}",       handle_library_page_delete )
+ROUTE( HTTP_GET,    "/programs",             handle_programs_get )
+ROUTE( HTTP_PUT,    "/programs/{id}",        handle_programs_put )
+ROUTE( HTTP_DELETE, "/programs/{id}",        handle_programs_delete )
+ROUTE( HTTP_PUT,    "/programs/monitor",     handle_programs_monitor_put )
+ROUTE( HTTP_GET,    "/stats/pages",          handle_stats_pages_get )
+ROUTE( HTTP_PUT,    "/stats/pages",          handle_stats_pages_put )
+ROUTE( HTTP_DELETE, "/stats/pages",          handle_stats_pages_delete )
+ROUTE( HTTP_GET,    "/metrics",              handle_metrics_get )
+ROUTE( HTTP_GET,    "/profile",              handle_profile_get )
+ROUTE( HTTP_PUT,    "/profile",              handle_profile_put )
+ROUTE( HTTP_DELETE, "/profile",              handle_profile_delete )
+ROUTE( HTTP_GET,    "/watch",                handle_watch_get )
+ROUTE( HTTP_POST,   "/watch",                handle_watch_post )
+ROUTE( HTTP_DELETE, "/watch/{id}",           handle_watch_delete )
+ROUTE( HTTP_GET,    "/watch/{id}/wait",      handle_watch_wait_get )
+ROUTE( HTTP_GET,    "/watchpoints",          handle_watchpoints_get )
+ROUTE( HTTP_POST,   "/watchpoints",          handle_watchpoints_post )
+ROUTE( HTTP_DELETE, "/watchpoints/{id}",     handle_watchpoints_delete )
+ROUTE( HTTP_GET,    "/watchpoints/hits",     handle_watchpoints_hits_get )
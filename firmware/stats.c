@@ -0,0 +1,421 @@
+/*
+ * Memory access statistics for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "mememul.h"
+#include "devices.h"
+#include "stats.h"
+#include "watchpoints.h"
+
+#define STATS_CYCLES_MARGIN 256       // Samples of the ring that may be overwritten while they are counted
+#define STATS_CYCLES_BATCH  256         // Max samples counted per call, not to delay the devices
+#define STATS_CLOCK_WINDOW  1000000     // Measurement window of the clock, in us
+#define STATS_PROFILE_START 0x0000      // Default window, the KIM-1 base RAM
+#define STATS_PROFILE_COUNT 0x0400
+
+// Bus cycle counters and clock measurements. The cycle monitor logs every bus
+// cycle, and core 1 counts them. Core 0 reads them while they are updated, so
+// they are guarded by a sequence number, odd while core 1 writes
+//
+typedef struct {
+    uint64_t cycles;                            // Cycles since the start
+    uint64_t card;                              // Cycles served by the card
+    uint64_t other;                             // Cycles not served by the card
+    uint32_t hz;                                // Clock frequency in the last window
+} clock_stats_t;
+
+static clock_stats_t clock_stats;
+static volatile uint32_t clock_seq = 0;
+
+// Page access counters. Core 1 adds up the cycles of each page, like the
+// cycle counters. They are reset by core 1 too, when asked by core 0, so no
+// count is lost or mixed with the previous ones
+//
+static uint32_t page_reads[STATS_NUM_PAGES];
+static uint32_t page_writes[STATS_NUM_PAGES];
+static volatile uint32_t page_samples;
+static volatile uint32_t page_dropped;
+
+static volatile bool pages_enabled = false;
+static volatile uint32_t pages_reset = 0;       // Incremented by core 0 to reset the counters
+
+// Execution profile. Core 1 samples the address of the bus cycle in progress
+// at random intervals, so the samples are not locked to the loops of the
+// program, and counts them for each address of the window
+//
+static uint32_t profile_hits[STATS_PROFILE_SIZE];
+static volatile uint32_t profile_samples;
+static volatile uint32_t profile_outside;       // Samples out of the window
+
+static volatile uint16_t profile_start = STATS_PROFILE_START;
+static volatile uint16_t profile_count = STATS_PROFILE_COUNT;   // Addresses in the window
+static volatile uint32_t profile_interval = STATS_PROFILE_INTERVAL; // Mean interval between samples, in us
+
+static volatile bool profile_enabled = false;
+static volatile uint32_t profile_reset = 0;     // Incremented by core 0 to reset the counters
+
+// Reset the counters and start counting
+//
+void stats_pages_start( void )
+{
+    pages_enabled = false;
+
+    ++pages_reset;
+    __sync_synchronize();
+    pages_enabled = true;
+}
+
+// Stop counting. The counters keep their values
+//
+void stats_pages_stop( void )
+{
+    pages_enabled = false;
+}
+
+// Start a new profile of the addresses from start to end, sampled every
+// interval microseconds on average. Returns false if the window is too big
+//
+bool stats_profile_start( uint16_t start, uint16_t end, uint32_t interval )
+{
+    if ( end < start || end - start >= STATS_PROFILE_SIZE || !interval )
+    {
+        return false;
+    }
+
+    profile_enabled = false;
+
+    profile_start = start;
+    profile_count = end - start + 1;
+    profile_interval = interval;
+
+    ++profile_reset;
+    __sync_synchronize();
+    profile_enabled = true;
+
+    return true;
+}
+
+// Stop sampling. The counters keep their values
+//
+void stats_profile_stop( void )
+{
+    profile_enabled = false;
+}
+
+// Count the cycles logged since the last call. If the ring has been
+// overwritten in the meantime, because the loop was busy with a device, the
+// logged cycles are left unclassified and counting resumes from the current
+// position
+//
+static void stats_poll_cycles( void )
+{
+    static bool started = false;
+    static uint32_t reset = 0, cursor, logged, count;
+    static uint32_t window;
+    static uint64_t window_cycles;
+    uint32_t now, us = time_us_32();
+    uint64_t cycle;
+    uint16_t address;
+    uint8_t data;
+    bool armed, card, read;
+
+    if ( !started )
+    {
+        started = true;
+
+        logged = count = mememul_pagemon_count();
+        cursor = count % MEMEMUL_PAGEMON_SIZE;
+        window = us;
+        window_cycles = 0;
+    }
+
+    if ( reset != pages_reset )
+    {
+        reset = pages_reset;
+
+        memset( page_reads, 0, sizeof( page_reads ) );
+        memset( page_writes, 0, sizeof( page_writes ) );
+        page_samples = page_dropped = 0;
+    }
+
+    ++clock_seq;
+    __sync_synchronize();
+
+    now = mememul_pagemon_count();
+    clock_stats.cycles += now - logged;
+    logged = now;
+
+    // Leave some margin, as the oldest samples could be overwritten while
+    // they are counted
+    //
+    if ( now - count >= MEMEMUL_PAGEMON_SIZE - STATS_CYCLES_MARGIN )
+    {
+        now = mememul_pagemon_count();
+        cursor = now % MEMEMUL_PAGEMON_SIZE;
+        clock_stats.cycles += now - logged;
+        logged = now;
+
+        if ( pages_enabled )
+        {
+            page_dropped += now - count;
+            page_samples += now - count;
+        }
+
+        count = now;
+    }
+
+    // Cycle count of the sample at the cursor, for the watchpoints
+    //
+    cycle = clock_stats.cycles - ( int32_t )( logged - count );
+    armed = watchpoints_sync();
+
+    for ( int i = 0; i < STATS_CYCLES_BATCH && mememul_pagemon_next( &cursor, &address, &data, &card, &read ); ++i )
+    {
+        if ( armed )
+        {
+            watchpoints_check( cycle, address, data, card, read );
+        }
+
+        if ( card )
+        {
+            ++clock_stats.card;
+        }
+        else
+        {
+            ++clock_stats.other;
+        }
+
+        if ( pages_enabled )
+        {
+            if ( read )
+            {
+                ++page_reads[address >> 8];
+            }
+            else
+            {
+                ++page_writes[address >> 8];
+            }
+
+            ++page_samples;
+        }
+
+        ++count;
+        ++cycle;
+    }
+
+    if ( us - window >= STATS_CLOCK_WINDOW )
+    {
+        clock_stats.hz = ( clock_stats.cycles - window_cycles ) * 1000000 / ( us - window );
+
+        window = us;
+        window_cycles = clock_stats.cycles;
+    }
+
+    __sync_synchronize();
+    ++clock_seq;
+}
+
+// Take a sample if it is time to. The intervals are uniformly distributed
+// around the mean, from a xorshift generator, which is good enough for this
+//
+static void stats_poll_profile( void )
+{
+    static uint32_t reset = 0, next, seed = 0x2545F491;
+    uint32_t now = time_us_32();
+    uint16_t address, offset;
+
+    if ( !profile_enabled )
+    {
+        return;
+    }
+
+    if ( reset != profile_reset )
+    {
+        reset = profile_reset;
+
+        memset( profile_hits, 0, sizeof( profile_hits ) );
+        profile_samples = profile_outside = 0;
+        next = now;
+    }
+
+    if ( ( int32_t )( now - next ) < 0 )
+    {
+        return;
+    }
+
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    next = now + 1 + seed % ( 2 * profile_interval );
+
+    if ( !mememul_bus_address( &address ) )
+    {
+        return;
+    }
+
+    ++profile_samples;
+
+    // The window can be changed by core 0 at any time, but the offset is
+    // always checked against a valid count
+    //
+    offset = address - profile_start;
+
+    if ( offset < profile_count )
+    {
+        ++profile_hits[offset];
+    }
+    else
+    {
+        ++profile_outside;
+    }
+}
+
+// Called from the core 1 loop
+//
+void stats_poll( void )
+{
+    stats_poll_cycles();
+    stats_poll_profile();
+}
+
+// Counters as JSON. Returns the length, or -1 if it does not fit
+//
+int stats_pages_json( char *buf, int size )
+{
+    int n = 0;
+
+#define STATS_ADD( expr ) do { n += ( expr ); if ( n >= size ) return -1; } while ( 0 )
+#define STATS_PUT( ... ) STATS_ADD( snprintf( &buf[n], size - n, __VA_ARGS__ ) )
+
+    STATS_PUT( "{\"enabled\":%s,\"samples\":%lu,\"dropped\":%lu,\"reads\":[", pages_enabled ? "true" : "false",
+               ( unsigned long ) page_samples, ( unsigned long ) page_dropped );
+
+    for ( int i = 0; i < STATS_NUM_PAGES; ++i )
+    {
+        STATS_PUT( "%s%lu", i ? "," : "", ( unsigned long ) page_reads[i] );
+    }
+
+    STATS_PUT( "],\"writes\":[" );
+
+    for ( int i = 0; i < STATS_NUM_PAGES; ++i )
+    {
+        STATS_PUT( "%s%lu", i ? "," : "", ( unsigned long ) page_writes[i] );
+    }
+
+    STATS_PUT( "]}" );
+
+#undef STATS_PUT
+#undef STATS_ADD
+
+    return ( n );
+}
+
+// Profile of the addresses from start to end as JSON, only those with hits.
+// If they do not fit, the profile is cut and "next" has the address to ask
+// for the rest from. Returns the length, or -1 if it does not fit at all
+//
+#define STATS_PROFILE_TAIL  24          // Room for the "next" member and the closing
+
+int stats_profile_json( char *buf, int size, uint16_t start, uint16_t end )
+{
+    uint32_t low = profile_start, count = profile_count;
+    int n = 0, len, entries = 0;
+
+#define STATS_ADD( expr ) do { n += ( expr ); if ( n >= size ) return -1; } while ( 0 )
+#define STATS_PUT( ... ) STATS_ADD( snprintf( &buf[n], size - n, __VA_ARGS__ ) )
+
+    STATS_PUT( "{\"enabled\":%s,\"start\":\"%04lx\",\"end\":\"%04lx\",\"interval\":%lu,\"samples\":%lu,\"outside\":%lu,\"hits\":[",
+               profile_enabled ? "true" : "false", ( unsigned long ) low, ( unsigned long )( low + count - 1 ),
+               ( unsigned long ) profile_interval, ( unsigned long ) profile_samples, ( unsigned long ) profile_outside );
+
+    for ( uint32_t address = MAX( start, low ); address <= end && address - low < count; ++address )
+    {
+        uint32_t hits = profile_hits[address - low];
+
+        if ( !hits )
+        {
+            continue;
+        }
+
+        len = snprintf( &buf[n], size - n, "%s[\"%04lx\",%lu]", entries ? "," : "",
+                        ( unsigned long ) address, ( unsigned long ) hits );
+
+        if ( n + len >= size - STATS_PROFILE_TAIL )
+        {
+            n += snprintf( &buf[n], size - n, "],\"next\":\"%04lx\"}", ( unsigned long ) address );
+            return ( n );
+        }
+
+        n += len;
+        ++entries;
+    }
+
+    STATS_PUT( "]}" );
+
+#undef STATS_PUT
+#undef STATS_ADD
+
+    return ( n );
+}
+
+// Cycle counters and clock measurements in the Prometheus text format.
+// Returns the length, or -1 if they do not fit
+//
+int stats_metrics( char *buf, int size )
+{
+    clock_stats_t c;
+    uint32_t seq;
+    int n = 0;
+
+    do
+    {
+        seq = clock_seq;
+        __sync_synchronize();
+        c = clock_stats;
+        __sync_synchronize();
+
+    } while ( ( seq & 1 ) || seq != clock_seq );
+
+#define STATS_ADD( expr ) do { n += ( expr ); if ( n >= size ) return -1; } while ( 0 )
+#define STATS_PUT( ... ) STATS_ADD( snprintf( &buf[n], size - n, __VA_ARGS__ ) )
+#define STATS_METRIC( name, type, help, fmt, value ) \
+    STATS_PUT( "# HELP " name " " help "\n# TYPE " name " " type "\n" name " " fmt "\n", value )
+
+    STATS_METRIC( "kim_cycles_total", "counter", "Bus cycles since the card started", "%llu", ( unsigned long long ) c.cycles );
+    STATS_METRIC( "kim_cycles_card_total", "counter", "Bus cycles served by the card", "%llu", ( unsigned long long ) c.card );
+    STATS_METRIC( "kim_cycles_other_total", "counter", "Bus cycles not served by the card", "%llu", ( unsigned long long ) c.other );
+    STATS_METRIC( "kim_cycles_unclassified_total", "counter", "Bus cycles not classified, because the card was busy", "%llu",
+                  ( unsigned long long )( c.cycles - c.card - c.other ) );
+    STATS_METRIC( "kim_clock_hz", "gauge", "PHI2 frequency in the last second", "%lu", ( unsigned long ) c.hz );
+    STATS_METRIC( "kim_tap_overruns_total", "counter", "Times the devices fell behind the 6502 writes and lost some", "%lu",
+                  ( unsigned long ) devices_overruns() );
+
+#undef STATS_METRIC
+#undef STATS_PUT
+#undef STATS_ADD
+
+    return ( n );
+}
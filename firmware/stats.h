@@ -0,0 +1,43 @@
+/*
+ * Memory access statistics for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define STATS_NUM_PAGES     256
+#define STATS_PROFILE_SIZE  4096        // Max addresses in the profile window
+#define STATS_PROFILE_INTERVAL 100      // Default mean interval between samples, in us
+#define STATS_PROFILE_MAX_INTERVAL 1000000
+
+void stats_pages_start( void );
+void stats_pages_stop( void );
+void stats_poll( void );
+int stats_pages_json( char *buf, int size );
+bool stats_profile_start( uint16_t start, uint16_t end, uint32_t interval );
+void stats_profile_stop( void );
+int stats_profile_json( char *buf, int size, uint16_t start, uint16_t end );
+int stats_metrics( char *buf, int size );
+
+#endif /* STATS_H */
@@ -0,0 +1,318 @@
+/*
+ * Request tracing for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "picowi.h"
+#include "trace.h"
+
+// Histograms are kept per web handler, plus one for requests that were not routed
+//
+#define TRACE_NUM_ROUTES    ( MAX_WEB_HANDLERS + 1 )
+#define TRACE_UNROUTED      MAX_WEB_HANDLERS
+
+typedef struct {
+    bool        active;
+    int         route;
+    uint32_t    start;                          // Timestamp of the first segment
+    uint32_t    mark[TRACE_NUM_PHASES];         // Timestamp of the start of each phase
+    uint32_t    phase[TRACE_NUM_PHASES];        // Accumulated time for each phase
+} trace_sock_t;
+
+typedef struct {
+    int         route;
+    uint32_t    start;
+    uint32_t    total;
+    uint32_t    phase[TRACE_NUM_PHASES];
+} trace_record_t;
+
+typedef struct {
+    uint32_t    count;
+    uint64_t    phase_sum[TRACE_NUM_PHASES];
+    uint32_t    buckets[TRACE_HIST_BUCKETS];
+} trace_hist_t;
+
+static trace_sock_t trace_socks[NUM_NET_SOCKETS];
+static trace_hist_t trace_hists[TRACE_NUM_ROUTES];
+static trace_record_t trace_records[TRACE_MAX_RECORDS];
+static int trace_num_records;
+static int trace_remaining;
+static int trace_tx_sock = -1;                  // Socket being sent, to account for SPI time
+
+static const char *trace_phase_names[TRACE_NUM_PHASES] = { "route", "parse", "handler", "tcp", "spi" };
+static const char *trace_method_names[] = { "GET", "POST", "PUT", "PATCH", "DELETE" };
+
+static inline void trace_phase_start( trace_sock_t *tsp, trace_phase_t phase, uint32_t now )
+{
+    tsp->mark[phase] = now;
+}
+
+static inline void trace_phase_end( trace_sock_t *tsp, trace_phase_t phase, uint32_t now )
+{
+    tsp->phase[phase] += now - tsp->mark[phase];
+}
+
+static int trace_bucket( uint32_t us )
+{
+    int bucket = us ? 32 - __builtin_clz( us ) : 0;
+
+    return MIN( bucket, TRACE_HIST_BUCKETS - 1 );
+}
+
+static int trace_route( int sock )
+{
+    web_handler_t handler = net_sockets[sock].web_handler;
+
+    for ( int i = 0; i < MAX_WEB_HANDLERS; ++i )
+    {
+        if ( web_handlers[i].handler == handler )
+        {
+            return i;
+        }
+    }
+
+    return TRACE_UNROUTED;
+}
+
+static void trace_done( trace_sock_t *tsp, uint32_t now )
+{
+    trace_hist_t *thp = &trace_hists[tsp->route];
+    uint32_t total = now - tsp->start;
+
+    // Make the phases disjoint: parsing is done before routing and SPI transmit
+    // inside the TCP send
+    //
+    tsp->phase[TRACE_PHASE_ROUTE] -= MIN( tsp->phase[TRACE_PHASE_ROUTE], tsp->phase[TRACE_PHASE_PARSE] );
+    tsp->phase[TRACE_PHASE_TCP] -= MIN( tsp->phase[TRACE_PHASE_TCP], tsp->phase[TRACE_PHASE_SPI] );
+
+    ++thp->count;
+    ++thp->buckets[trace_bucket( total )];
+    for ( int p = 0; p < TRACE_NUM_PHASES; ++p )
+    {
+        thp->phase_sum[p] += tsp->phase[p];
+    }
+
+    if ( trace_remaining && trace_num_records < TRACE_MAX_RECORDS )
+    {
+        trace_record_t *trp = &trace_records[trace_num_records++];
+
+        trp->route = tsp->route;
+        trp->start = tsp->start;
+        trp->total = total;
+        memcpy( trp->phase, tsp->phase, sizeof( trp->phase ) );
+        --trace_remaining;
+    }
+
+    tsp->active = false;
+}
+
+static void trace_hook( int sock, net_trace_point_t point )
+{
+    uint32_t now = time_us_32();
+    trace_sock_t *tsp;
+
+    // SPI transmits are not socket-aware, assign them to the socket being sent
+    //
+    if ( sock < 0 )
+    {
+        sock = trace_tx_sock;
+    }
+
+    if ( sock < 0 || sock >= NUM_NET_SOCKETS )
+    {
+        return;
+    }
+
+    tsp = &trace_socks[sock];
+
+    if ( point == NET_TRACE_RX )
+    {
+        memset( tsp, 0, sizeof( trace_sock_t ) );
+        tsp->active = true;
+        tsp->route  = TRACE_UNROUTED;
+        tsp->start  = now;
+        return;
+    }
+
+    if ( !tsp->active )
+    {
+        return;
+    }
+
+    switch ( point )
+    {
+        case NET_TRACE_PARSE_START:
+            trace_phase_start( tsp, TRACE_PHASE_PARSE, now );
+            break;
+
+        case NET_TRACE_PARSE_END:
+            trace_phase_end( tsp, TRACE_PHASE_PARSE, now );
+            break;
+
+        case NET_TRACE_ROUTED:
+            tsp->route = trace_route( sock );
+            tsp->phase[TRACE_PHASE_ROUTE] = now - tsp->start;
+            break;
+
+        case NET_TRACE_HANDLER_START:
+            trace_phase_start( tsp, TRACE_PHASE_HANDLER, now );
+            break;
+
+        case NET_TRACE_HANDLER_END:
+            trace_phase_end( tsp, TRACE_PHASE_HANDLER, now );
+            break;
+
+        case NET_TRACE_TCP_START:
+            trace_tx_sock = sock;
+            trace_phase_start( tsp, TRACE_PHASE_TCP, now );
+            break;
+
+        case NET_TRACE_TCP_END:
+            trace_tx_sock = -1;
+            trace_phase_end( tsp, TRACE_PHASE_TCP, now );
+            break;
+
+        case NET_TRACE_SPI_START:
+            trace_phase_start( tsp, TRACE_PHASE_SPI, now );
+            break;
+
+        case NET_TRACE_SPI_END:
+            trace_phase_end( tsp, TRACE_PHASE_SPI, now );
+            break;
+
+        case NET_TRACE_DONE:
+            trace_done( tsp, now );
+            break;
+
+        case NET_TRACE_ABORT:
+        default:
+            tsp->active = false;
+            break;
+    }
+}
+
+// Record the phases of the next 'count' requests. Discards previous records.
+//
+void trace_arm( int count )
+{
+    trace_num_records = 0;
+    trace_remaining = MIN( count, TRACE_MAX_RECORDS );
+}
+
+static int trace_json_route( char *buf, int size, int route )
+{
+    if ( route == TRACE_UNROUTED || !web_handlers[route].uri )
+    {
+        return snprintf( buf, size, "\"method\":null,\"uri\":null" );
+    }
+
+    return snprintf( buf, size, "\"method\":\"%s\",\"uri\":\"%s\"",
+                        trace_method_names[web_handlers[route].method], web_handlers[route].uri );
+}
+
+static int trace_json_phases( char *buf, int size, uint32_t *phase )
+{
+    int n = 0;
+
+    for ( int p = 0; p < TRACE_NUM_PHASES && n < size; ++p )
+    {
+        n += snprintf( &buf[n], size - n, "%s\"%s\":%lu", p ? "," : "",
+                        trace_phase_names[p], (unsigned long) phase[p] );
+    }
+
+    return n;
+}
+
+// Render histograms and per-request records as JSON. Returns the length of
+// the rendered string, or -1 if it does not fit into the buffer
+//
+int trace_json( char *buf, int size )
+{
+    int n = 0, sep = 0;
+
+#define TRACE_ADD( expr ) do { n += ( expr ); if ( n >= size ) return -1; } while ( 0 )
+#define TRACE_PUT( ... ) TRACE_ADD( snprintf( &buf[n], size - n, __VA_ARGS__ ) )
+
+    TRACE_PUT( "{\"histograms\":[" );
+
+    for ( int r = 0; r < TRACE_NUM_ROUTES; ++r )
+    {
+        trace_hist_t *thp = &trace_hists[r];
+        uint32_t phase_avg[TRACE_NUM_PHASES];
+        int last;
+
+        if ( !thp->count )
+        {
+            continue;
+        }
+
+        for ( last = TRACE_HIST_BUCKETS - 1; last > 0 && !thp->buckets[last]; --last );
+
+        for ( int p = 0; p < TRACE_NUM_PHASES; ++p )
+        {
+            phase_avg[p] = thp->phase_sum[p] / thp->count;
+        }
+
+        TRACE_PUT( "%s{", sep++ ? "," : "" );
+        TRACE_ADD( trace_json_route( &buf[n], size - n, r ) );
+        TRACE_PUT( ",\"count\":%lu,\"avg\":{", (unsigned long) thp->count );
+        TRACE_ADD( trace_json_phases( &buf[n], size - n, phase_avg ) );
+        TRACE_PUT( "},\"buckets\":[" );
+        for ( int b = 0; b <= last; ++b )
+        {
+            TRACE_PUT( "%s%lu", b ? "," : "", (unsigned long) thp->buckets[b] );
+        }
+        TRACE_PUT( "]}" );
+    }
+
+    TRACE_PUT( "],\"remaining\":%d,\"requests\":[", trace_remaining );
+
+    for ( int i = 0; i < trace_num_records; ++i )
+    {
+        trace_record_t *trp = &trace_records[i];
+
+        TRACE_PUT( "%s{", i ? "," : "" );
+        TRACE_ADD( trace_json_route( &buf[n], size - n, trp->route ) );
+        TRACE_PUT( ",\"start\":%lu,\"total\":%lu,\"phases\":{", (unsigned long) trp->start, (unsigned long) trp->total );
+        TRACE_ADD( trace_json_phases( &buf[n], size - n, trp->phase ) );
+        TRACE_PUT( "}}" );
+    }
+
+    TRACE_PUT( "]}\n" );
+
+#undef TRACE_PUT
+#undef TRACE_ADD
+
+    return n;
+}
+
+void trace_setup( void )
+{
+    for ( int i = 0; i < NUM_NET_SOCKETS; ++i )
+    {
+        trace_socks[i].active = false;
+    }
+
+    net_set_trace_hook( trace_hook );
+}
@@ -0,0 +1,44 @@
+/*
+ * Request tracing for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_HIST_BUCKETS  24          // Log2 buckets: bucket n counts latencies < 2^n us
+#define TRACE_MAX_RECORDS   16          // Max number of requests in the per-request trace
+
+typedef enum {
+    TRACE_PHASE_ROUTE,                  // From first segment to handler dispatch, excluding header parsing
+    TRACE_PHASE_PARSE,                  // Request line and header parsing
+    TRACE_PHASE_HANDLER,                // Handler body
+    TRACE_PHASE_TCP,                    // TCP send, excluding SPI transmit
+    TRACE_PHASE_SPI,                    // SPI transmit to the WiFi chip
+    TRACE_NUM_PHASES
+} trace_phase_t;
+
+void trace_setup( void );
+void trace_arm( int count );
+int trace_json( char *buf, int size );
+
+#endif /* TRACE_H */
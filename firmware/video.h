@@ -27,6 +27,7 @@
 
 void video_setup( uint16_t *mem_map );
 void video_set_mem_start( uint16_t mem_start );
+uint16_t video_get_mem_start( void );
 
 
 #endif /* VIDEO_H */
@@ -0,0 +1,202 @@
+/*
+ * Watch expressions for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "config.h"
+#include "watch.h"
+
+static const char *watch_cond_names[WATCH_NUM_CONDS] = { "eq", "ne", "changed" };
+
+static watch_t watches[WATCH_MAX_WATCHES];
+static int watch_next_id = 1;
+
+watch_cond_t watch_cond( const char *name )
+{
+    watch_cond_t cond;
+
+    for ( cond = 0; cond < WATCH_NUM_CONDS && strcmp( name, watch_cond_names[cond] ); ++cond );
+
+    return ( cond );
+}
+
+// Register a watch. Returns its id, or -1 if there are no free slots
+//
+int watch_add( uint16_t address, watch_cond_t cond, uint8_t value, uint8_t mask, uint32_t interval_ms )
+{
+    for ( int i = 0; i < WATCH_MAX_WATCHES; ++i )
+    {
+        watch_t *w = &watches[i];
+
+        if ( !w->id )
+        {
+            memset( w, 0, sizeof( watch_t ) );
+            w->address = address;
+            w->cond = cond;
+            w->value = value & mask;
+            w->mask = mask;
+            w->last = mem_map[address] & mask;
+            w->interval = interval_ms * 1000;
+            w->checked = time_us_32();
+
+            // Ids are not reused until they wrap, so a stale id does not
+            // refer to a newer watch
+            //
+            w->id = watch_next_id;
+            watch_next_id = watch_next_id == 0x7FFFFFFF ? 1 : watch_next_id + 1;
+
+            return ( w->id );
+        }
+    }
+
+    return ( -1 );
+}
+
+watch_t *watch_find( int id )
+{
+    for ( int i = 0; i < WATCH_MAX_WATCHES; ++i )
+    {
+        if ( id > 0 && watches[i].id == id )
+        {
+            return ( &watches[i] );
+        }
+    }
+
+    return ( NULL );
+}
+
+bool watch_delete( int id )
+{
+    watch_t *w = watch_find( id );
+
+    if ( w )
+    {
+        w->id = 0;
+    }
+
+    return ( w != NULL );
+}
+
+// Take the event of a watch that fired, so the next wait blocks until it
+// fires again. Returns false if it did not fire
+//
+bool watch_take( watch_t *w, uint8_t *value )
+{
+    if ( !w->fired )
+    {
+        return ( false );
+    }
+
+    w->fired = false;
+    *value = w->fired_value;
+
+    return ( true );
+}
+
+// Evaluate the watches that are due. eq and ne hold while the masked data
+// is, or is not, equal to the value, and fire when they start to hold, which
+// includes the first evaluation. changed fires whenever the masked data
+// differs from the previous evaluation. The event is kept until a wait takes
+// it, so short pulses are not lost
+//
+void watch_poll( void )
+{
+    uint32_t now = time_us_32();
+
+    for ( int i = 0; i < WATCH_MAX_WATCHES; ++i )
+    {
+        watch_t *w = &watches[i];
+        uint8_t data;
+        bool holds;
+
+        if ( !w->id || now - w->checked < w->interval )
+        {
+            continue;
+        }
+
+        w->checked = now;
+        data = mem_map[w->address];
+
+        switch ( w->cond )
+        {
+            case WATCH_EQ:
+                holds = ( data & w->mask ) == w->value;
+                break;
+
+            case WATCH_NE:
+                holds = ( data & w->mask ) != w->value;
+                break;
+
+            default:
+                holds = ( data & w->mask ) != w->last;
+                break;
+        }
+
+        w->last = data & w->mask;
+
+        if ( holds && ( !w->held || w->cond == WATCH_CHANGED ) && !w->fired )
+        {
+            w->fired = true;
+            w->fired_value = data;
+            ++w->count;
+        }
+
+        w->held = holds;
+    }
+}
+
+// List the registered watches as JSON. Returns the length, or -1 if it does
+// not fit in the buffer
+//
+int watch_json( char *buf, int size )
+{
+    int n = 0, sep = 0;
+
+#define WATCH_ADD( expr ) do { n += ( expr ); if ( n >= size ) return -1; } while ( 0 )
+#define WATCH_PUT( ... ) WATCH_ADD( snprintf( &buf[n], size - n, __VA_ARGS__ ) )
+
+    WATCH_PUT( "[" );
+
+    for ( int i = 0; i < WATCH_MAX_WATCHES; ++i )
+    {
+        watch_t *w = &watches[i];
+
+        if ( !w->id )
+        {
+            continue;
+        }
+
+        WATCH_PUT( "%s{\"id\":%d,\"address\":\"%04x\",\"cond\":\"%s\",\"value\":\"%02x\",\"mask\":\"%02x\","
+                   "\"interval\":%lu,\"fired\":%s,\"count\":%lu}",
+                   sep++ ? "," : "", w->id, w->address, watch_cond_names[w->cond], w->value, w->mask,
+                   (unsigned long) w->interval / 1000, w->fired ? "true" : "false", (unsigned long) w->count );
+    }
+
+    WATCH_PUT( "]" );
+
+#undef WATCH_PUT
+#undef WATCH_ADD
+
+    return ( n );
+}
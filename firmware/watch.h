@@ -0,0 +1,60 @@
+/*
+ * Watch expressions for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WATCH_MAX_WATCHES   8
+#define WATCH_INTERVAL_MS   10          // Default evaluation interval
+#define WATCH_MAX_INTERVAL_MS 60000
+#define WATCH_WAIT_MS       30000       // Default long poll timeout
+#define WATCH_MAX_WAIT_MS   600000
+
+typedef enum { WATCH_EQ, WATCH_NE, WATCH_CHANGED, WATCH_NUM_CONDS } watch_cond_t;
+
+typedef struct {
+    int         id;                     // 0 if the slot is free
+    uint16_t    address;
+    watch_cond_t cond;
+    uint8_t     value;                  // Compared against the data, after masking
+    uint8_t     mask;
+    uint8_t     last;                   // Masked data at the previous evaluation
+    uint32_t    interval;               // Evaluation interval, in us
+    uint32_t    checked;                // Time of the last evaluation
+    bool        held;                   // Condition held at the previous evaluation
+    bool        fired;                  // Condition fired since the last wait took it
+    uint8_t     fired_value;            // Data when it held
+    uint32_t    count;                  // Times it fired
+} watch_t;
+
+watch_cond_t watch_cond( const char *name );
+int watch_add( uint16_t address, watch_cond_t cond, uint8_t value, uint8_t mask, uint32_t interval_ms );
+watch_t *watch_find( int id );
+bool watch_delete( int id );
+bool watch_take( watch_t *w, uint8_t *value );
+void watch_poll( void );
+int watch_json( char *buf, int size );
+
+#endif /* WATCH_H */
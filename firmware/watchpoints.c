@@ -0,0 +1,275 @@
+/*
+ * Bus watchpoints for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#include "watchpoints.h"
+
+// Watchpoints. Core 1 checks every bus cycle logged by the cycle monitor
+// against them, and logs the cycles that match into a ring, with the cycle
+// count as timestamp. Core 0 edits them and reads the ring
+//
+static const char *watchpoint_rw_names[] = { "", "r", "w", "rw" };
+
+static watchpoint_t watchpoints[WATCHPOINTS_MAX];
+static volatile uint32_t watchpoints_seq = 0;   // Odd while core 0 edits them
+static int watchpoints_next_id = 1;
+
+static watchpoint_t armed[WATCHPOINTS_MAX];     // Copy used by core 1
+static int armed_count = 0;
+
+static watchpoint_hit_t hits[WATCHPOINTS_HITS];
+static volatile uint32_t hits_head = 0;         // Hits since the start
+
+// Cycle directions of a watchpoint by name. Returns 0 if invalid
+//
+int watchpoints_rw( const char *name )
+{
+    for ( int rw = WATCHPOINT_READ; rw <= ( WATCHPOINT_READ | WATCHPOINT_WRITE ); ++rw )
+    {
+        if ( !strcmp( name, watchpoint_rw_names[rw] ) )
+        {
+            return ( rw );
+        }
+    }
+
+    return ( 0 );
+}
+
+static void watchpoints_edit_begin( void )
+{
+    ++watchpoints_seq;
+    __sync_synchronize();
+}
+
+static void watchpoints_edit_end( void )
+{
+    __sync_synchronize();
+    ++watchpoints_seq;
+}
+
+// Set a watchpoint on the cycles with the masked address and data. Returns
+// its id, or -1 if there are no free slots
+//
+int watchpoints_add( uint16_t address, uint16_t mask, int rw, uint8_t value, uint8_t value_mask )
+{
+    for ( int i = 0; i < WATCHPOINTS_MAX; ++i )
+    {
+        watchpoint_t *w = &watchpoints[i];
+
+        if ( !w->id )
+        {
+            watchpoints_edit_begin();
+
+            w->address = address & mask;
+            w->mask = mask;
+            w->rw = rw;
+            w->value = value & value_mask;
+            w->value_mask = value_mask;
+
+            // Ids are not reused until they wrap, as with the watches
+            //
+            w->id = watchpoints_next_id;
+            watchpoints_next_id = watchpoints_next_id == 0x7FFFFFFF ? 1 : watchpoints_next_id + 1;
+
+            watchpoints_edit_end();
+
+            return ( w->id );
+        }
+    }
+
+    return ( -1 );
+}
+
+bool watchpoints_delete( int id )
+{
+    for ( int i = 0; i < WATCHPOINTS_MAX; ++i )
+    {
+        if ( id > 0 && watchpoints[i].id == id )
+        {
+            watchpoints_edit_begin();
+            watchpoints[i].id = 0;
+            watchpoints_edit_end();
+
+            return ( true );
+        }
+    }
+
+    return ( false );
+}
+
+// Called from core 1 before checking a batch of cycles. Takes a new copy of
+// the watchpoints if core 0 has changed them. If it changes them again while
+// copying, there are none until the next call. Returns false if there are none
+//
+bool watchpoints_sync( void )
+{
+    static uint32_t seq = 0;
+    uint32_t now = watchpoints_seq;
+
+    if ( now != seq && !( now & 1 ) )
+    {
+        __sync_synchronize();
+
+        armed_count = 0;
+
+        for ( int i = 0; i < WATCHPOINTS_MAX; ++i )
+        {
+            if ( watchpoints[i].id )
+            {
+                armed[armed_count++] = watchpoints[i];
+            }
+        }
+
+        __sync_synchronize();
+
+        if ( watchpoints_seq == now )
+        {
+            seq = now;
+        }
+        else
+        {
+            armed_count = 0;
+        }
+    }
+
+    return ( armed_count != 0 );
+}
+
+// Check a bus cycle against the watchpoints, from core 1. A cycle is logged
+// once, for the first watchpoint that matches
+//
+void watchpoints_check( uint64_t cycle, uint16_t address, uint8_t data, bool card, bool read )
+{
+    for ( int i = 0; i < armed_count; ++i )
+    {
+        watchpoint_t *w = &armed[i];
+        watchpoint_hit_t *h;
+
+        if ( ( address & w->mask ) != w->address
+            || !( w->rw & ( read ? WATCHPOINT_READ : WATCHPOINT_WRITE ) )
+            || ( data & w->value_mask ) != w->value )
+        {
+            continue;
+        }
+
+        h = &hits[hits_head % WATCHPOINTS_HITS];
+
+        h->cycle = cycle;
+        h->id = w->id;
+        h->address = address;
+        h->data = data;
+        h->read = read;
+        h->card = card;
+
+        __sync_synchronize();
+        ++hits_head;
+
+        return;
+    }
+}
+
+// List the watchpoints as JSON. Returns the length, or -1 if it does not fit
+// in the buffer
+//
+int watchpoints_json( char *buf, int size )
+{
+    int n = 0, sep = 0;
+
+#define WATCHPOINTS_ADD( expr ) do { n += ( expr ); if ( n >= size ) return -1; } while ( 0 )
+#define WATCHPOINTS_PUT( ... ) WATCHPOINTS_ADD( snprintf( &buf[n], size - n, __VA_ARGS__ ) )
+
+    WATCHPOINTS_PUT( "[" );
+
+    for ( int i = 0; i < WATCHPOINTS_MAX; ++i )
+    {
+        watchpoint_t *w = &watchpoints[i];
+
+        if ( !w->id )
+        {
+            continue;
+        }
+
+        WATCHPOINTS_PUT( "%s{\"id\":%d,\"address\":\"%04x\",\"mask\":\"%04x\",\"rw\":\"%s\",\"value\":\"%02x\",\"vmask\":\"%02x\"}",
+                         sep++ ? "," : "", w->id, w->address, w->mask, watchpoint_rw_names[w->rw], w->value, w->value_mask );
+    }
+
+    WATCHPOINTS_PUT( "]" );
+
+#undef WATCHPOINTS_PUT
+#undef WATCHPOINTS_ADD
+
+    return ( n );
+}
+
+// Hits from the since sequence number on as JSON, with the sequence number
+// to ask for the next ones. The hits that have been overwritten in the ring
+// are counted in "lost". Returns the length, or -1 if it does not fit in the
+// buffer
+//
+int watchpoints_hits_json( char *buf, int size, uint32_t since )
+{
+    uint32_t head = hits_head, first, lost;
+    watchpoint_hit_t h;
+    int n = 0, sep = 0;
+
+    if ( ( int32_t )( head - since ) < 0 )
+    {
+        since = head;
+    }
+
+    first = head - since > WATCHPOINTS_HITS ? head - WATCHPOINTS_HITS : since;
+    lost = first - since;
+
+#define WATCHPOINTS_ADD( expr ) do { n += ( expr ); if ( n >= size ) return -1; } while ( 0 )
+#define WATCHPOINTS_PUT( ... ) WATCHPOINTS_ADD( snprintf( &buf[n], size - n, __VA_ARGS__ ) )
+
+    WATCHPOINTS_PUT( "{\"next\":%lu,\"hits\":[", ( unsigned long ) head );
+
+    for ( uint32_t seq = first; seq != head; ++seq )
+    {
+        h = hits[seq % WATCHPOINTS_HITS];
+
+        // Core 1 may have overwritten it while it was copied
+        //
+        __sync_synchronize();
+
+        if ( hits_head - seq >= WATCHPOINTS_HITS )
+        {
+            ++lost;
+            continue;
+        }
+
+        WATCHPOINTS_PUT( "%s{\"seq\":%lu,\"id\":%d,\"cycle\":%llu,\"address\":\"%04x\",\"data\":\"%02x\",\"rw\":\"%s\",\"card\":%s}",
+                         sep++ ? "," : "", ( unsigned long ) seq, h.id, ( unsigned long long ) h.cycle, h.address, h.data,
+                         h.read ? "r" : "w", h.card ? "true" : "false" );
+    }
+
+    WATCHPOINTS_PUT( "],\"lost\":%lu}", ( unsigned long ) lost );
+
+#undef WATCHPOINTS_PUT
+#undef WATCHPOINTS_ADD
+
+    return ( n );
+}
@@ -0,0 +1,61 @@
+/*
+ * Bus watchpoints for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef WATCHPOINTS_H
+#define WATCHPOINTS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WATCHPOINTS_MAX     4
+#define WATCHPOINTS_HITS    64          // Hits kept in the ring
+
+#define WATCHPOINT_READ     1
+#define WATCHPOINT_WRITE    2
+
+typedef struct {
+    int         id;                     // 0 if the slot is free
+    uint16_t    address;
+    uint16_t    mask;                   // Address bits compared
+    uint8_t     rw;                     // WATCHPOINT_READ, WATCHPOINT_WRITE or both
+    uint8_t     value;                  // Compared against the data, after masking
+    uint8_t     value_mask;             // Data bits compared, 0 for any data
+} watchpoint_t;
+
+typedef struct {
+    uint64_t    cycle;                  // Bus cycle, as counted by the cycle monitor
+    int         id;
+    uint16_t    address;
+    uint8_t     data;
+    bool        read;
+    bool        card;                   // The card served the cycle
+} watchpoint_hit_t;
+
+int watchpoints_rw( const char *name );
+int watchpoints_add( uint16_t address, uint16_t mask, int rw, uint8_t value, uint8_t value_mask );
+bool watchpoints_delete( int id );
+bool watchpoints_sync( void );
+void watchpoints_check( uint64_t cycle, uint16_t address, uint8_t data, bool card, bool read );
+int watchpoints_json( char *buf, int size );
+int watchpoints_hits_json( char *buf, int size, uint32_t since );
+
+#endif /* WATCHPOINTS_H */
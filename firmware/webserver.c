@@ -29,8 +29,28 @@
 #include "picowi.h"
 #include "httpd.h"
 #include "video.h"
+#include "trace.h"
+#include "crc.h"
+#include "monitor.h"
+#include "watch.h"
+#include "mailbox.h"
+#include "devices.h"
+#include "library.h"
+#include "programs.h"
+#include "stats.h"
+#include "watchpoints.h"
+#include "acia.h"
 
 #define MAX_DATA_LEN ( TCP_MSS - TCP_DATA_OFFSET )
+#define TRACE_JSON_LEN 8192
+#define WATCH_JSON_LEN 1024
+#define DEVICES_JSON_LEN 512
+#define PROGRAMS_JSON_LEN 2048
+#define STATS_JSON_LEN 6144
+#define PROFILE_JSON_LEN 8192
+#define METRICS_LEN 1024
+#define WATCHPOINTS_JSON_LEN 512
+#define HITS_JSON_LEN 8192
 
 typedef enum { AC_ENABLE, AC_DISABLE, AC_SETRAM, AC_SETROM } action_t;
 
@@ -72,34 +92,37 @@ static int _handle_ramrom_range( int sock, char *req, int oset, int module, data
 
     int datalen;
 
-    static http_request_t http_req = {0};
+    // Requests span several segments and may be interleaved with those of
+    // other sockets, so keep their state per socket
+    //
+    static http_request_t http_reqs[TCP_NUM_SOCKETS] = {0};
+    http_request_t *http_req = &http_reqs[sock];
 
     if ( req )
     {
-        if ( http_req.seq == ts->seq )
+        if ( http_req->seq == ts->seq )
         {
             //printf( "Received datalen: %d, accumulated: %d\n", oset, received );
-            copy_fn( &http_req, req, oset );
+            copy_fn( http_req, ( uint8_t * )req, oset );
         }
         else
         {
             //printf( "Request Length: %d\n", oset );
 
-            if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+            if ( httpd_init_http_request( http_req, ts, req, oset ) )
             {
                 return ( web_400_bad_request( sock ) );
             }
 
-            datalen = oset - ((char *)http_req.bodyp - req);
+            datalen = oset;
 
-            printf( "\nTCP socket %d Rx %s\n", sock, strtok( req, "\r\n" ) );
             //printf( "Remaining Data Len (after headers): %d\n", datalen );
         
-            for ( int i= 0; i < http_req.paramcount; ++i )
+            for ( int i= 0; i < http_req->paramcount; ++i )
             {
-                if ( strcmp( "start", http_req.params[i] ) == 0 )
+                if ( strcmp( "start", http_req->params[i] ) == 0 )
                 {
-                    start = http_req.param_vals[i];
+                    start = http_req->param_vals[i];
                     ++num_args;
                 }
             }
@@ -111,22 +134,22 @@ static int _handle_ramrom_range( int sock, char *req, int oset, int module, data
 
             u_start = strtoul( start, &ends, 16 );
 
-            if ( *ends || !http_req.content_len || http_req.content_len % module || u_start + http_req.content_len/module - 1 > 0xFFFF )
+            if ( *ends || !http_req->content_len || http_req->content_len % module || u_start + http_req->content_len/module - 1 > 0xFFFF )
             {
                 return ( web_400_bad_request( sock ) );
             }
 
-            http_req.buf = (uint8_t *)&mem_map[u_start];
+            http_req->buf = (uint8_t *)&mem_map[u_start];
 
             if ( datalen )
             {
-                copy_fn( &http_req, http_req.bodyp, datalen );
+                copy_fn( http_req, http_req->bodyp, datalen );
             }
 
         }
     }
 
-    if ( http_req.recvd == http_req.content_len )
+    if ( http_req->recvd == http_req->content_len )
     {
         //printf( "Request completed. Received %d bytes.\n", received );
 
@@ -177,8 +200,6 @@ static int _handle_ramrom_actions_patch( int sock, char *req, int oset, action_t
             return ( web_400_bad_request( sock ) );
         }
 
-        printf( "\nTCP socket %d Rx %s\n", sock, strtok( req, "\r\n" ) );
-
         for ( int i= 0; i < http_req.paramcount; ++i )
         {
             if ( strcmp( "start", http_req.params[i] ) == 0 )
@@ -265,6 +286,72 @@ static int handle_ramrom_setram_patch( int sock, char *req, int oset )
     return _handle_ramrom_actions_patch( sock, req, oset, AC_SETRAM );
 }
 
+// Parses a single "bytes=first-last", "bytes=first-" or "bytes=-suffix" range.
+// Returns 1 if valid, 0 if it must be ignored (malformed or multiple ranges,
+// so the whole content is sent) or -1 if not satisfiable
+//
+static int parse_range( const char *range, uint32_t len, uint32_t *first, uint32_t *last )
+{
+    char *end;
+    uint32_t u_first, u_last;
+
+    if ( strncmp( range, "bytes=", 6 ) || strchr( range, ',' ) )
+    {
+        return 0;
+    }
+
+    range += 6;
+
+    if ( *range == '-' )
+    {
+        u_last = strtoul( ++range, &end, 10 );
+
+        if ( end == range || *end )
+        {
+            return 0;
+        }
+        if ( !u_last )
+        {
+            return -1;
+        }
+
+        *first = u_last < len ? len - u_last : 0;
+        *last = len - 1;
+
+        return 1;
+    }
+
+    u_first = strtoul( range, &end, 10 );
+
+    if ( end == range || *end != '-' )
+    {
+        return 0;
+    }
+
+    range = end + 1;
+    u_last = len - 1;
+
+    if ( *range )
+    {
+        u_last = strtoul( range, &end, 10 );
+
+        if ( *end || u_last < u_first )
+        {
+            return 0;
+        }
+    }
+
+    if ( u_first >= len )
+    {
+        return -1;
+    }
+
+    *first = u_first;
+    *last = MIN( u_last, len - 1 );
+
+    return 1;
+}
+
 // Handler for GET /ramrom/range
 static int handle_ramrom_get( int sock, char *req, int oset )
 {
@@ -273,34 +360,37 @@ static int handle_ramrom_get( int sock, char *req, int oset )
     NET_SOCKET *ts = &net_sockets[sock];
 
     uint32_t u_start, u_count;
+    uint32_t first, last, crc;
 
     char *start, *count;
     int num_args = 0;
 
     char *ends, *endc;
 
-    static http_request_t http_req = {0};
+    char *match, *range, *if_range;
+    char etag[12];
+    char header[64];
 
+    static http_request_t http_reqs[TCP_NUM_SOCKETS] = {0};
+    http_request_t *http_req = &http_reqs[sock];
 
     if ( req )
     {
-        if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+        if ( httpd_init_http_request( http_req, ts, req, oset ) )
         {
             return ( web_400_bad_request( sock ) );
         }
 
-        printf( "\nTCP socket %d Rx %s\n", sock, strtok( req, "\r\n" ) );
-
-        for (int i= 0; i < http_req.paramcount; ++i )
+        for (int i= 0; i < http_req->paramcount; ++i )
         {
-            if ( strcmp( "start", http_req.params[i] ) == 0 )
+            if ( strcmp( "start", http_req->params[i] ) == 0 )
             {
-                start = http_req.param_vals[i];
+                start = http_req->param_vals[i];
                 ++num_args;
             }
-            else if ( strcmp( "count", http_req.params[i] ) == 0 )
+            else if ( strcmp( "count", http_req->params[i] ) == 0 )
             {
-                count = http_req.param_vals[i];
+                count = http_req->param_vals[i];
                 ++num_args;
             }
         }
@@ -320,24 +410,75 @@ static int handle_ramrom_get( int sock, char *req, int oset )
         
         u_count *= 2;
 
-        http_req.buf = (uint8_t *)&mem_map[u_start];
-        http_req.content_len = u_count;
+        // Strong validator: CRC of the whole selected range, data and attributes
+        //
+        crc = crc_calc( &mem_map[u_start], u_count );
+        sprintf( etag, "\"%08lx\"", (unsigned long) crc );
+        sprintf( header, HTTP_ETAG, (unsigned long) crc );
 
-        n = web_resp_add_str( sock,
-            HTTP_200_OK HTTP_SERVER HTTP_NOCACHE HTTP_CONTENT_BINARY );
-        n += web_resp_add_content_len( sock, u_count );
+        match = httpd_get_header( http_req, WEB_HDR_IF_NONE_MATCH );
+
+        if ( match && ( strstr( match, etag ) || !strcmp( match, "*" ) ) )
+        {
+            n = web_resp_add_str( sock, HTTP_304_NOT_MODIFIED HTTP_SERVER HTTP_REVALIDATE );
+            n += web_resp_add_str( sock, header );
+            n += web_resp_add_str( sock, HTTP_CONNECTION_CLOSE HTTP_HEADER_END );
+            tcp_sock_close( sock );
+            return ( n );
+        }
+
+        // Byte ranges apply to the raw content, two bytes per address. A range
+        // with an If-Range that does not match is ignored
+        //
+        first = 0;
+        last = u_count - 1;
+
+        range = httpd_get_header( http_req, WEB_HDR_RANGE );
+        if_range = httpd_get_header( http_req, WEB_HDR_IF_RANGE );
+
+        switch ( range && ( !if_range || !strcmp( if_range, etag ) ) ? parse_range( range, u_count, &first, &last ) : 0 )
+        {
+            case -1:
+                n = web_resp_add_str( sock, HTTP_416_FAIL HTTP_SERVER HTTP_REVALIDATE );
+                n += web_resp_add_str( sock, header );
+                sprintf( header, HTTP_RANGE_UNSATISFIED, (int) u_count );
+                n += web_resp_add_str( sock, header );
+                n += web_resp_add_content_len( sock, 0 );
+                n += web_resp_add_str( sock, HTTP_CONNECTION_CLOSE HTTP_HEADER_END );
+                tcp_sock_close( sock );
+                return ( n );
+
+            case 1:
+                n = web_resp_add_str( sock, HTTP_206_PARTIAL );
+                n += web_resp_add_str( sock, header );
+                sprintf( header, HTTP_CONTENT_RANGE, (int) first, (int) last, (int) u_count );
+                n += web_resp_add_str( sock, header );
+                break;
+
+            default:
+                n = web_resp_add_str( sock, HTTP_200_OK );
+                n += web_resp_add_str( sock, header );
+                break;
+        }
+
+        http_req->buf = (uint8_t *)&mem_map[u_start] + first;
+        http_req->content_len = last - first + 1;
+
+        n += web_resp_add_str( sock,
+            HTTP_SERVER HTTP_REVALIDATE HTTP_ACCEPT_RANGES HTTP_CONTENT_BINARY );
+        n += web_resp_add_content_len( sock, http_req->content_len );
         n += web_resp_add_str( sock, HTTP_CONNECTION_CLOSE HTTP_HEADER_END );
-        http_req.hlen = n;
+        http_req->hlen = n;
 
-        n += web_resp_add_data( sock, http_req.buf, MIN( u_count, MAX_DATA_LEN - http_req.hlen ) );
+        n += web_resp_add_data( sock, http_req->buf, MIN( http_req->content_len, MAX_DATA_LEN - http_req->hlen ) );
     }
     else
     {
-        n = MIN( MAX_DATA_LEN, http_req.content_len + http_req.hlen - oset );
+        n = MIN( MAX_DATA_LEN, http_req->content_len + http_req->hlen - oset );
 
         if ( n > 0 )
         {
-            web_resp_add_data( sock, &http_req.buf[oset - http_req.hlen], n );
+            web_resp_add_data( sock, &http_req->buf[oset - http_req->hlen], n );
         }
         else
         {
@@ -355,9 +496,6 @@ static int handle_restore_put( int sock, char *req, int oset )
 
     if ( req )
     {
-
-        printf( "\nTCP socket %d Rx %s\n", sock, strtok( req, "\r\n" ) );
-
         config_copy_default_memory_map( mem_map );
         
         n = web_resp_add_str( sock,
@@ -393,8 +531,6 @@ static int handle_video_put( int sock, char *req, int oset )
             return ( web_400_bad_request( sock ) );
         }
 
-        printf( "\nTCP socket %d Rx %s\n", sock, strtok( req, "\r\n" ) );
-
         for ( int i= 0; i < http_req.paramcount; ++i )
         {
             if ( strcmp( "address", http_req.params[i] ) == 0 )
@@ -429,34 +565,1389 @@ static int handle_video_put( int sock, char *req, int oset )
 
 }
 
-void webserver_run( void )
+// Send a JSON response of several segments. The first call, with the request,
+// sends the headers and the first segment, and the next ones, from the Tx
+// poll, the rest. The JSON must stay in place until the response is sent
+//
+static int send_long_json( int sock, char *req, int oset, http_request_t *http_req, char *json, int len )
 {
-    int server_sock;
-    struct sockaddr_in server_addr;
+    int n = 0;
 
-    server_sock = socket( AF_INET, SOCK_STREAM, 0) ;
-    memset( &server_addr, 0, sizeof( server_addr ) ); 
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY; 
-    server_addr.sin_port = htons( HTTPORT );         
-    if ( server_sock < 0 ||
-        bind( server_sock, ( struct sockaddr * )&server_addr, sizeof( server_addr ) ) < 0 ||
-        listen( server_sock, 3 ) < 0 )
-    { 
-        perror( "socket/bind/listen failed" ); 
-        return; 
+    if ( req )
+    {
+        http_req->buf = (uint8_t *)json;
+        http_req->content_len = len;
+
+        n = web_resp_add_str( sock,
+            HTTP_200_OK HTTP_SERVER HTTP_NOCACHE HTTP_CONTENT_JSON );
+        n += web_resp_add_content_len( sock, len );
+        n += web_resp_add_str( sock, HTTP_CONNECTION_CLOSE HTTP_HEADER_END );
+        http_req->hlen = n;
+
+        n += web_resp_add_data( sock, http_req->buf, MIN( len, MAX_DATA_LEN - http_req->hlen ) );
     }
-    
-    printf( "Web server on port %u\n", HTTPORT );
-    web_page_handler( HTTP_GET,   "/ramrom/range",         handle_ramrom_get );
-    web_page_handler( HTTP_PATCH, "/ramrom/range/data",    handle_ramrom_data_patch );
-    web_page_handler( HTTP_PATCH, "/ramrom/range/enable",  handle_ramrom_enable_patch );
-    web_page_handler( HTTP_PATCH, "/ramrom/range/disable", handle_ramrom_disable_patch );
-    web_page_handler( HTTP_PATCH, "/ramrom/range/setrom",  handle_ramrom_setrom_patch );
-    web_page_handler( HTTP_PATCH, "/ramrom/range/setram",  handle_ramrom_setram_patch );
-    web_page_handler( HTTP_PATCH, "/ramrom/range",         handle_ramrom_patch );
-    web_page_handler( HTTP_PUT,   "/ramrom/restore",       handle_restore_put );
-    web_page_handler( HTTP_PUT,   "/ramrom/video",         handle_video_put );
+    else
+    {
+        n = MIN( MAX_DATA_LEN, http_req->content_len + http_req->hlen - oset );
+
+        if ( n > 0 )
+        {
+            web_resp_add_data( sock, &http_req->buf[oset - http_req->hlen], n );
+        }
+        else
+        {
+            tcp_sock_close( sock );
+        }
+    }
+
+    return ( n );
+}
+
+// Some handlers can only serve one connection at a time, like those that
+// build long JSON responses in a single buffer, too large to have one per
+// socket. Claims the handler for the socket, or returns false while another
+// connection is still being served by it
+//
+static bool claim_handler( int sock, int *owner, web_handler_t handler )
+{
+    NET_SOCKET *os;
+
+    if ( *owner >= 0 && *owner != sock )
+    {
+        os = &net_sockets[*owner];
+
+        if ( os->state == T_ESTABLISHED && os->web_handler == handler )
+        {
+            return ( false );
+        }
+    }
+
+    *owner = sock;
+
+    return ( true );
+}
+
+// Handler for GET /system/trace
+static int handle_trace_get( int sock, char *req, int oset )
+{
+    int len = 0;
+
+    static char trace_buf[TRACE_JSON_LEN];
+    static int trace_owner = -1;
+    static http_request_t http_reqs[TCP_NUM_SOCKETS] = {0};
+
+    if ( req && !claim_handler( sock, &trace_owner, handle_trace_get ) )
+    {
+        return ( web_503_unavailable( sock ) );
+    }
+
+    if ( req && ( len = trace_json( trace_buf, sizeof( trace_buf ) ) ) < 0 )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    return ( send_long_json( sock, req, oset, &http_reqs[sock], trace_buf, len ) );
+}
+
+// Handler for PUT /system/trace
+static int handle_trace_put( int sock, char *req, int oset )
+{
+    int n = 0;
+
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    char *count;
+    int num_args = 0;
+
+    uint32_t u_count;
+
+    char *ends;
+
+    http_request_t http_req = {0};
+
+    if ( req )
+    {
+        if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        for ( int i= 0; i < http_req.paramcount; ++i )
+        {
+            if ( strcmp( "count", http_req.params[i] ) == 0 )
+            {
+                count = http_req.param_vals[i];
+                ++num_args;
+            }
+        }
+
+        if ( num_args != 1 || !count )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        u_count = strtoul( count, &ends, 10 );
+
+        if ( *ends || u_count > TRACE_MAX_RECORDS )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        trace_arm( ( int )u_count );
+
+        n = web_resp_add_str( sock,
+                        HTTP_200_OK HTTP_SERVER HTTP_NOCACHE );
+        n += web_resp_add_content_len(sock, 0);
+        n += web_resp_add_str(sock, HTTP_CONNECTION_CLOSE HTTP_HEADER_END);
+        tcp_sock_close( sock );
+    }
+
+    return ( n );
+}
+
+// Parse a number in the given base, up to max
+//
+static bool parse_number( const char *str, int base, uint32_t max, uint32_t *value )
+{
+    char *end;
+
+    if ( !str || !*str )
+    {
+        return ( false );
+    }
+
+    *value = strtoul( str, &end, base );
+
+    return ( !*end && *value <= max );
+}
+
+// Send a short JSON response, in a single segment
+//
+static int send_json( int sock, const char *json )
+{
+    int n;
+
+    n = web_resp_add_str( sock, HTTP_200_OK HTTP_SERVER HTTP_NOCACHE HTTP_CONTENT_JSON );
+    n += web_resp_add_content_len( sock, strlen( json ) );
+    n += web_resp_add_str( sock, HTTP_CONNECTION_CLOSE HTTP_HEADER_END );
+    n += web_resp_add_str( sock, ( char * )json );
+    tcp_sock_close( sock );
+
+    return ( n );
+}
+
+// Handler for POST /watch
+static int handle_watch_post( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    char *address = NULL, *cond = NULL, *value = NULL, *mask = NULL, *interval = NULL;
+    uint32_t u_address, u_value = 0, u_mask = 0xFF, u_interval = WATCH_INTERVAL_MS;
+    watch_cond_t c;
+    int id;
+
+    char json[32];
+
+    http_request_t http_req = {0};
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    for ( int i= 0; i < http_req.paramcount; ++i )
+    {
+        if ( strcmp( "address", http_req.params[i] ) == 0 )
+        {
+            address = http_req.param_vals[i];
+        }
+        else if ( strcmp( "cond", http_req.params[i] ) == 0 )
+        {
+            cond = http_req.param_vals[i];
+        }
+        else if ( strcmp( "value", http_req.params[i] ) == 0 )
+        {
+            value = http_req.param_vals[i];
+        }
+        else if ( strcmp( "mask", http_req.params[i] ) == 0 )
+        {
+            mask = http_req.param_vals[i];
+        }
+        else if ( strcmp( "interval", http_req.params[i] ) == 0 )
+        {
+            interval = http_req.param_vals[i];
+        }
+    }
+
+    if ( !cond || ( c = watch_cond( cond ) ) == WATCH_NUM_CONDS
+        || !parse_number( address, 16, 0xFFFF, &u_address )
+        || ( c != WATCH_CHANGED && !parse_number( value, 16, 0xFF, &u_value ) )
+        || ( mask && !parse_number( mask, 16, 0xFF, &u_mask ) )
+        || ( interval && ( !parse_number( interval, 10, WATCH_MAX_INTERVAL_MS, &u_interval ) || !u_interval ) ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    if ( ( id = watch_add( u_address, c, u_value, u_mask, u_interval ) ) < 0 )
+    {
+        return ( web_503_unavailable( sock ) );
+    }
+
+    sprintf( json, "{\"id\":%d}", id );
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for GET /watch
+static int handle_watch_get( int sock, char *req, int oset )
+{
+    char json[WATCH_JSON_LEN];
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( watch_json( json, sizeof( json ) ) < 0 )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for DELETE /watch/{id}
+static int handle_watch_delete( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+    uint32_t id;
+
+    http_request_t http_req = {0};
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( httpd_init_http_request( &http_req, ts, req, oset ) || !parse_number( http_req.path_params[0], 10, INT32_MAX, &id ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    if ( !watch_delete( id ) )
+    {
+        return ( web_404_not_found( sock ) );
+    }
+
+    return ( send_json( sock, "{}" ) );
+}
+
+// Handler for GET /watch/{id}/wait
+//
+// Long poll: the response is held until the watch fires, or until the
+// timeout expires, in which case "fired" is false
+//
+static int handle_watch_wait_get( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    char *timeout = NULL;
+    uint32_t id, u_timeout = WATCH_WAIT_MS;
+    uint8_t value;
+    watch_t *w;
+
+    char json[64];
+
+    static struct {
+        int id;
+        uint32_t start;
+        uint32_t timeout;
+    } waits[TCP_NUM_SOCKETS];
+
+    http_request_t http_req = {0};
+
+    if ( req )
+    {
+        if ( httpd_init_http_request( &http_req, ts, req, oset ) || !parse_number( http_req.path_params[0], 10, INT32_MAX, &id ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        for ( int i= 0; i < http_req.paramcount; ++i )
+        {
+            if ( strcmp( "timeout", http_req.params[i] ) == 0 )
+            {
+                timeout = http_req.param_vals[i];
+            }
+        }
+
+        if ( timeout && !parse_number( timeout, 10, WATCH_MAX_WAIT_MS, &u_timeout ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        waits[sock].id = id;
+        waits[sock].start = time_us_32();
+        waits[sock].timeout = u_timeout * 1000;
+    }
+
+    // The watch may have been deleted while waiting
+    //
+    if ( !( w = watch_find( waits[sock].id ) ) )
+    {
+        return ( web_404_not_found( sock ) );
+    }
+
+    if ( watch_take( w, &value ) )
+    {
+        sprintf( json, "{\"id\":%d,\"fired\":true,\"value\":\"%02x\"}", w->id, value );
+    }
+    else if ( time_us_32() - waits[sock].start >= waits[sock].timeout )
+    {
+        sprintf( json, "{\"id\":%d,\"fired\":false}", w->id );
+    }
+    else
+    {
+        return ( 0 );
+    }
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for PUT /mailbox
+static int handle_mailbox_put( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    char *address = NULL, *size = NULL;
+    uint32_t u_address, u_size = MAILBOX_SIZE;
+
+    char json[80];
+
+    http_request_t http_req = {0};
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    for ( int i= 0; i < http_req.paramcount; ++i )
+    {
+        if ( strcmp( "address", http_req.params[i] ) == 0 )
+        {
+            address = http_req.param_vals[i];
+        }
+        else if ( strcmp( "size", http_req.params[i] ) == 0 )
+        {
+            size = http_req.param_vals[i];
+        }
+    }
+
+    if ( !parse_number( address, 16, 0xFFFF, &u_address )
+        || ( size && !parse_number( size, 10, MAILBOX_MAX_SIZE, &u_size ) )
+        || !mailbox_setup( u_address, u_size ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    mailbox_json( json, sizeof( json ) );
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for POST /mailbox
+//
+// Adds the body to the host to KIM-1 ring. The response has the number of
+// bytes added, which is less than the body length if the ring is full
+//
+static int handle_mailbox_post( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    int written;
+    char json[32];
+
+    static uint8_t bodies[TCP_NUM_SOCKETS][MAILBOX_MAX_SIZE];
+    static http_request_t http_reqs[TCP_NUM_SOCKETS] = {0};
+    http_request_t *http_req = &http_reqs[sock];
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( http_req->seq != ts->seq )
+    {
+        if ( httpd_init_http_request( http_req, ts, req, oset ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        if ( !mailbox_configured() )
+        {
+            return ( web_503_unavailable( sock ) );
+        }
+
+        if ( http_req->content_len > MAILBOX_MAX_SIZE )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        http_req->buf = bodies[sock];
+        req = ( char * )http_req->bodyp;
+    }
+
+    oset = MIN( oset, http_req->content_len - http_req->recvd );
+    raw_data_copy( http_req, ( uint8_t * )req, oset );
+
+    if ( http_req->recvd < http_req->content_len )
+    {
+        return ( 0 );
+    }
+
+    written = mailbox_put( http_req->buf, http_req->content_len );
+    sprintf( json, "{\"written\":%d}", written );
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for GET /mailbox
+//
+// Long poll: the response is held until the KIM-1 adds data to its ring, or
+// until the timeout expires, and has the data taken from the ring, if any
+//
+static int handle_mailbox_get( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    char *timeout = NULL;
+    uint32_t u_timeout = MAILBOX_WAIT_MS;
+    uint8_t data[MAILBOX_MAX_SIZE];
+    int n, len;
+
+    static struct {
+        uint32_t start;
+        uint32_t timeout;
+    } waits[TCP_NUM_SOCKETS];
+
+    http_request_t http_req = {0};
+
+    if ( req )
+    {
+        if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        for ( int i= 0; i < http_req.paramcount; ++i )
+        {
+            if ( strcmp( "timeout", http_req.params[i] ) == 0 )
+            {
+                timeout = http_req.param_vals[i];
+            }
+        }
+
+        if ( timeout && !parse_number( timeout, 10, MAILBOX_MAX_WAIT_MS, &u_timeout ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        if ( !mailbox_configured() )
+        {
+            return ( web_503_unavailable( sock ) );
+        }
+
+        waits[sock].start = time_us_32();
+        waits[sock].timeout = u_timeout * 1000;
+    }
+
+    if ( mailbox_ready() )
+    {
+        len = mailbox_get( data, sizeof( data ) );
+    }
+    else if ( time_us_32() - waits[sock].start >= waits[sock].timeout )
+    {
+        len = 0;
+    }
+    else
+    {
+        return ( 0 );
+    }
+
+    n = web_resp_add_str( sock, HTTP_200_OK HTTP_SERVER HTTP_NOCACHE HTTP_CONTENT_BINARY );
+    n += web_resp_add_content_len( sock, len );
+    n += web_resp_add_str( sock, HTTP_CONNECTION_CLOSE HTTP_HEADER_END );
+    if ( len )
+    {
+        n += web_resp_add_data( sock, data, len );
+    }
+    tcp_sock_close( sock );
+
+    return ( n );
+}
+
+// Handler for GET /devices
+static int handle_devices_get( int sock, char *req, int oset )
+{
+    char json[DEVICES_JSON_LEN];
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( devices_json( json, sizeof( json ) ) < 0 )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for PUT /devices/{name}
+static int handle_devices_put( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    char *address = NULL;
+    uint32_t u_address;
+    int device;
+
+    char json[DEVICES_JSON_LEN];
+
+    http_request_t http_req = {0};
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    if ( ( device = devices_find( http_req.path_params[0] ) ) < 0 )
+    {
+        return ( web_404_not_found( sock ) );
+    }
+
+    for ( int i= 0; i < http_req.paramcount; ++i )
+    {
+        if ( strcmp( "address", http_req.params[i] ) == 0 )
+        {
+            address = http_req.param_vals[i];
+        }
+    }
+
+    if ( !parse_number( address, 16, 0xFFFF, &u_address ) || !devices_enable( device, u_address ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    devices_json( json, sizeof( json ) );
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for DELETE /devices/{name}
+static int handle_devices_delete( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+    int device;
+
+    http_request_t http_req = {0};
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    if ( ( device = devices_find( http_req.path_params[0] ) ) < 0 )
+    {
+        return ( web_404_not_found( sock ) );
+    }
+
+    devices_disable( device );
+
+    return ( send_json( sock, "{}" ) );
+}
+
+// Handler for GET /library
+static int handle_library_get( int sock, char *req, int oset )
+{
+    char json[48];
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    sprintf( json, "{\"pages\":%d,\"page_size\":%d}", LIBRARY_ROM_PAGES, LIBRARY_PAGE_SIZE );
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for GET /library/{page}
+static int handle_library_page_get( int sock, char *req, int oset )
+{
+    int n = 0;
+
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    uint32_t u_page;
+
+    static http_request_t http_reqs[TCP_NUM_SOCKETS] = {0};
+    http_request_t *http_req = &http_reqs[sock];
+
+    if ( req )
+    {
+        if ( httpd_init_http_request( http_req, ts, req, oset ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        if ( !parse_number( http_req->path_params[0], 10, LIBRARY_ROM_PAGES - 1, &u_page ) )
+        {
+            return ( web_404_not_found( sock ) );
+        }
+
+        http_req->buf = ( uint8_t * )library_page( u_page );
+        http_req->content_len = LIBRARY_PAGE_SIZE;
+
+        n = web_resp_add_str( sock, HTTP_200_OK HTTP_SERVER HTTP_NOCACHE HTTP_CONTENT_BINARY );
+        n += web_resp_add_content_len( sock, http_req->content_len );
+        n += web_resp_add_str( sock, HTTP_CONNECTION_CLOSE HTTP_HEADER_END );
+        http_req->hlen = n;
+
+        n += web_resp_add_data( sock, http_req->buf, MIN( http_req->content_len, MAX_DATA_LEN - http_req->hlen ) );
+    }
+    else
+    {
+        n = MIN( MAX_DATA_LEN, http_req->content_len + http_req->hlen - oset );
+
+        if ( n > 0 )
+        {
+            web_resp_add_data( sock, &http_req->buf[oset - http_req->hlen], n );
+        }
+        else
+        {
+            tcp_sock_close( sock );
+        }
+    }
+
+    return ( n );
+}
+
+// Chunk being received of each library upload
+//
+static uint8_t library_chunks[TCP_NUM_SOCKETS][LIBRARY_CHUNK_SIZE];
+
+// Write request body data to consecutive library pages, from page. The body
+// is programmed in chunks as it arrives, and each page is erased before its
+// first chunk. The rest of the last chunk reads as $FF
+//
+static bool library_body_copy( http_request_t *http_req, int page, uint8_t *data, int len )
+{
+    int chunk, n, p;
+    uint32_t offset;
+
+    len = MIN( len, http_req->content_len - http_req->recvd );
+
+    while ( len )
+    {
+        chunk = http_req->recvd % LIBRARY_CHUNK_SIZE;
+        n = MIN( len, LIBRARY_CHUNK_SIZE - chunk );
+
+        memcpy( &http_req->buf[chunk], data, n );
+        http_req->recvd += n;
+        data += n;
+        len -= n;
+
+        if ( chunk + n == LIBRARY_CHUNK_SIZE || http_req->recvd == http_req->content_len )
+        {
+            memset( &http_req->buf[chunk + n], 0xFF, LIBRARY_CHUNK_SIZE - chunk - n );
+
+            offset = http_req->recvd - chunk - n;
+            p = page + offset / LIBRARY_PAGE_SIZE;
+            offset %= LIBRARY_PAGE_SIZE;
+
+            if ( ( !offset && !library_erase( p ) )
+                || !library_program( p, offset, http_req->buf, LIBRARY_CHUNK_SIZE ) )
+            {
+                return ( false );
+            }
+        }
+    }
+
+    return ( true );
+}
+
+// Handler for PUT /library/{page}
+//
+// Erases the page and writes the body to it, up to a page. The rest of the
+// page reads as $FF
+//
+static int handle_library_page_put( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    uint32_t u_page;
+    char json[32];
+
+    static int pages[TCP_NUM_SOCKETS];
+    static http_request_t http_reqs[TCP_NUM_SOCKETS] = {0};
+    http_request_t *http_req = &http_reqs[sock];
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( http_req->seq != ts->seq )
+    {
+        if ( httpd_init_http_request( http_req, ts, req, oset ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        if ( !parse_number( http_req->path_params[0], 10, LIBRARY_ROM_PAGES - 1, &u_page ) )
+        {
+            return ( web_404_not_found( sock ) );
+        }
+
+        if ( http_req->content_len > LIBRARY_PAGE_SIZE )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        // An empty body just erases the page
+        //
+        if ( !http_req->content_len && !library_erase( u_page ) )
+        {
+            return ( web_503_unavailable( sock ) );
+        }
+
+        pages[sock] = u_page;
+        http_req->buf = library_chunks[sock];
+        req = ( char * )http_req->bodyp;
+    }
+
+    if ( !library_body_copy( http_req, pages[sock], ( uint8_t * )req, oset ) )
+    {
+        return ( web_503_unavailable( sock ) );
+    }
+
+    if ( http_req->recvd < http_req->content_len )
+    {
+        return ( 0 );
+    }
+
+    sprintf( json, "{\"page\":%d,\"written\":%d}", pages[sock], http_req->recvd );
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for DELETE /library/{page}
+static int handle_library_page_delete( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    uint32_t u_page;
+
+    http_request_t http_req = {0};
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    if ( !parse_number( http_req.path_params[0], 10, LIBRARY_ROM_PAGES - 1, &u_page ) )
+    {
+        return ( web_404_not_found( sock ) );
+    }
+
+    if ( !library_erase( u_page ) )
+    {
+        return ( web_503_unavailable( sock ) );
+    }
+
+    return ( send_json( sock, "{}" ) );
+}
+
+// Handler for GET /programs
+static int handle_programs_get( int sock, char *req, int oset )
+{
+    static char json[PROGRAMS_JSON_LEN];
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( programs_json( json, sizeof( json ) ) < 0 )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for PUT /programs/{id}
+//
+// Adds the body to the program library, replacing the program with the same
+// ID, if any. The image is written to the library as it arrives, and added
+// to the catalog when complete
+//
+static int handle_programs_put( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    char *address = NULL;
+    uint32_t u_id, u_address;
+    char json[48];
+
+    static struct {
+        uint8_t id;
+        uint16_t address;
+        int page;
+    } uploads[TCP_NUM_SOCKETS];
+    static int upload_owner = -1;
+    static http_request_t http_reqs[TCP_NUM_SOCKETS] = {0};
+    http_request_t *http_req = &http_reqs[sock];
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( http_req->seq != ts->seq )
+    {
+        if ( httpd_init_http_request( http_req, ts, req, oset ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        for ( int i= 0; i < http_req->paramcount; ++i )
+        {
+            if ( strcmp( "address", http_req->params[i] ) == 0 )
+            {
+                address = http_req->param_vals[i];
+            }
+        }
+
+        if ( !parse_number( http_req->path_params[0], 16, 0xFE, &u_id ) || !u_id
+            || !parse_number( address, 16, 0xFFFF, &u_address )
+            || !http_req->content_len || u_address + http_req->content_len > PROGRAMS_MAX_LEN )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        // The pages of an upload are not reserved until it is committed, so
+        // only one can be in progress
+        //
+        if ( !claim_handler( sock, &upload_owner, handle_programs_put )
+            || ( uploads[sock].page = programs_begin( u_id, u_address, http_req->content_len ) ) < 0 )
+        {
+            return ( web_503_unavailable( sock ) );
+        }
+
+        uploads[sock].id = u_id;
+        uploads[sock].address = u_address;
+        http_req->buf = library_chunks[sock];
+        req = ( char * )http_req->bodyp;
+    }
+
+    if ( !library_body_copy( http_req, uploads[sock].page, ( uint8_t * )req, oset ) )
+    {
+        return ( web_503_unavailable( sock ) );
+    }
+
+    if ( http_req->recvd < http_req->content_len )
+    {
+        return ( 0 );
+    }
+
+    if ( !programs_commit( uploads[sock].id, uploads[sock].address, http_req->content_len, uploads[sock].page ) )
+    {
+        return ( web_503_unavailable( sock ) );
+    }
+
+    sprintf( json, "{\"id\":\"%02x\",\"address\":\"%04x\",\"length\":%d}",
+             uploads[sock].id, uploads[sock].address, http_req->content_len );
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for DELETE /programs/{id}
+static int handle_programs_delete( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+
+    uint32_t u_id;
+
+    http_request_t http_req = {0};
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    if ( !parse_number( http_req.path_params[0], 16, 0xFF, &u_id ) || !programs_find( u_id ) )
+    {
+        return ( web_404_not_found( sock ) );
+    }
+
+    if ( !programs_delete( u_id ) )
+    {
+        return ( web_503_unavailable( sock ) );
+    }
+
+    return ( send_json( sock, "{}" ) );
+}
+
+// Handler for PUT /programs/monitor
+//
+// Patches the tape load routine of the monitor in the memory map, so it
+// loads from the library through the loader device
+//
+static int handle_programs_monitor_put( int sock, char *req, int oset )
+{
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( !programs_patch_monitor() )
+    {
+        return ( web_503_unavailable( sock ) );
+    }
+
+    return ( send_json( sock, "{}" ) );
+}
+
+// Handler for GET /stats/pages
+static int handle_stats_pages_get( int sock, char *req, int oset )
+{
+    int len = 0;
+
+    static char stats_buf[STATS_JSON_LEN];
+    static int stats_owner = -1;
+    static http_request_t http_reqs[TCP_NUM_SOCKETS] = {0};
+
+    if ( req && !claim_handler( sock, &stats_owner, handle_stats_pages_get ) )
+    {
+        return ( web_503_unavailable( sock ) );
+    }
+
+    if ( req && ( len = stats_pages_json( stats_buf, sizeof( stats_buf ) ) ) < 0 )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    return ( send_long_json( sock, req, oset, &http_reqs[sock], stats_buf, len ) );
+}
+
+// Handler for PUT /stats/pages
+static int handle_stats_pages_put( int sock, char *req, int oset )
+{
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    stats_pages_start();
+
+    return ( send_json( sock, "{}" ) );
+}
+
+// Handler for DELETE /stats/pages
+static int handle_stats_pages_delete( int sock, char *req, int oset )
+{
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    stats_pages_stop();
+
+    return ( send_json( sock, "{}" ) );
+}
+
+// Handler for GET /metrics
+static int handle_metrics_get( int sock, char *req, int oset )
+{
+    char metrics[METRICS_LEN];
+    int n, len;
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( ( len = stats_metrics( metrics, sizeof( metrics ) ) ) < 0 )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    n = web_resp_add_str( sock, HTTP_200_OK HTTP_SERVER HTTP_NOCACHE HTTP_CONTENT_TEXT );
+    n += web_resp_add_content_len( sock, len );
+    n += web_resp_add_str( sock, HTTP_CONNECTION_CLOSE HTTP_HEADER_END );
+    n += web_resp_add_data( sock, ( BYTE * )metrics, len );
+    tcp_sock_close( sock );
+
+    return ( n );
+}
+
+// Handler for POST /watchpoints
+static int handle_watchpoints_post( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+    http_request_t http_req = {0};
+
+    char *address = NULL, *mask = NULL, *rw = NULL, *value = NULL, *vmask = NULL;
+    uint32_t u_address, u_mask = 0xFFFF, u_value = 0, u_vmask = 0;
+    int r = WATCHPOINT_READ | WATCHPOINT_WRITE, id;
+    char json[32];
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    for ( int i= 0; i < http_req.paramcount; ++i )
+    {
+        if ( strcmp( "address", http_req.params[i] ) == 0 )
+        {
+            address = http_req.param_vals[i];
+        }
+        else if ( strcmp( "mask", http_req.params[i] ) == 0 )
+        {
+            mask = http_req.param_vals[i];
+        }
+        else if ( strcmp( "rw", http_req.params[i] ) == 0 )
+        {
+            rw = http_req.param_vals[i];
+        }
+        else if ( strcmp( "value", http_req.params[i] ) == 0 )
+        {
+            value = http_req.param_vals[i];
+        }
+        else if ( strcmp( "vmask", http_req.params[i] ) == 0 )
+        {
+            vmask = http_req.param_vals[i];
+        }
+    }
+
+    // With a value, all the data bits are compared by default
+    //
+    if ( value )
+    {
+        u_vmask = 0xFF;
+    }
+
+    if ( !parse_number( address, 16, 0xFFFF, &u_address )
+        || ( mask && !parse_number( mask, 16, 0xFFFF, &u_mask ) )
+        || ( rw && !( r = watchpoints_rw( rw ) ) )
+        || ( value && !parse_number( value, 16, 0xFF, &u_value ) )
+        || ( vmask && !parse_number( vmask, 16, 0xFF, &u_vmask ) ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    if ( ( id = watchpoints_add( u_address, u_mask, r, u_value, u_vmask ) ) < 0 )
+    {
+        return ( web_503_unavailable( sock ) );
+    }
+
+    sprintf( json, "{\"id\":%d}", id );
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for GET /watchpoints
+static int handle_watchpoints_get( int sock, char *req, int oset )
+{
+    char json[WATCHPOINTS_JSON_LEN];
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( watchpoints_json( json, sizeof( json ) ) < 0 )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    return ( send_json( sock, json ) );
+}
+
+// Handler for DELETE /watchpoints/{id}
+static int handle_watchpoints_delete( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+    uint32_t id;
+
+    http_request_t http_req = {0};
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( httpd_init_http_request( &http_req, ts, req, oset ) || !parse_number( http_req.path_params[0], 10, INT32_MAX, &id ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    if ( !watchpoints_delete( id ) )
+    {
+        return ( web_404_not_found( sock ) );
+    }
+
+    return ( send_json( sock, "{}" ) );
+}
+
+// Handler for GET /watchpoints/hits
+static int handle_watchpoints_hits_get( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+    http_request_t http_req = {0};
+    char *since = NULL;
+    uint32_t u_since = 0;
+    int len = 0;
+
+    static char hits_buf[HITS_JSON_LEN];
+    static int hits_owner = -1;
+    static http_request_t http_reqs[TCP_NUM_SOCKETS] = {0};
+
+    if ( req )
+    {
+        if ( !claim_handler( sock, &hits_owner, handle_watchpoints_hits_get ) )
+        {
+            return ( web_503_unavailable( sock ) );
+        }
+
+        if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        for ( int i= 0; i < http_req.paramcount; ++i )
+        {
+            if ( strcmp( "since", http_req.params[i] ) == 0 )
+            {
+                since = http_req.param_vals[i];
+            }
+        }
+
+        if ( ( since && !parse_number( since, 10, UINT32_MAX, &u_since ) )
+            || ( len = watchpoints_hits_json( hits_buf, sizeof( hits_buf ), u_since ) ) < 0 )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+    }
+
+    return ( send_long_json( sock, req, oset, &http_reqs[sock], hits_buf, len ) );
+}
+
+// Parse a 6502 address range, as "start-end" in hex
+//
+static bool parse_address_range( const char *str, uint16_t *start, uint16_t *end )
+{
+    char first[5];
+    const char *dash;
+    uint32_t u_start, u_end;
+
+    if ( !str || !( dash = strchr( str, '-' ) ) || dash - str >= sizeof( first ) )
+    {
+        return ( false );
+    }
+
+    memcpy( first, str, dash - str );
+    first[dash - str] = '\0';
+
+    if ( !parse_number( first, 16, 0xFFFF, &u_start ) || !parse_number( dash + 1, 16, 0xFFFF, &u_end ) || u_end < u_start )
+    {
+        return ( false );
+    }
+
+    *start = u_start;
+    *end = u_end;
+
+    return ( true );
+}
+
+// Handler for GET /profile
+static int handle_profile_get( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+    http_request_t http_req = {0};
+    int len = 0;
+    char *range = NULL;
+    uint16_t start = 0, end = 0xFFFF;
+
+    static char profile_buf[PROFILE_JSON_LEN];
+    static int profile_owner = -1;
+    static http_request_t http_reqs[TCP_NUM_SOCKETS] = {0};
+
+    if ( req )
+    {
+        if ( !claim_handler( sock, &profile_owner, handle_profile_get ) )
+        {
+            return ( web_503_unavailable( sock ) );
+        }
+
+        if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+
+        for ( int i= 0; i < http_req.paramcount; ++i )
+        {
+            if ( strcmp( "range", http_req.params[i] ) == 0 )
+            {
+                range = http_req.param_vals[i];
+            }
+        }
+
+        if ( ( range && !parse_address_range( range, &start, &end ) )
+            || ( len = stats_profile_json( profile_buf, sizeof( profile_buf ), start, end ) ) < 0 )
+        {
+            return ( web_400_bad_request( sock ) );
+        }
+    }
+
+    return ( send_long_json( sock, req, oset, &http_reqs[sock], profile_buf, len ) );
+}
+
+// Handler for PUT /profile
+static int handle_profile_put( int sock, char *req, int oset )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+    http_request_t http_req = {0};
+    char *range = NULL, *interval = NULL;
+    uint16_t start, end;
+    uint32_t u_interval = STATS_PROFILE_INTERVAL;
+
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    if ( httpd_init_http_request( &http_req, ts, req, oset ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    for ( int i= 0; i < http_req.paramcount; ++i )
+    {
+        if ( strcmp( "range", http_req.params[i] ) == 0 )
+        {
+            range = http_req.param_vals[i];
+        }
+        else if ( strcmp( "interval", http_req.params[i] ) == 0 )
+        {
+            interval = http_req.param_vals[i];
+        }
+    }
+
+    if ( !parse_address_range( range, &start, &end )
+        || ( interval && !parse_number( interval, 10, STATS_PROFILE_MAX_INTERVAL, &u_interval ) )
+        || !stats_profile_start( start, end, u_interval ) )
+    {
+        return ( web_400_bad_request( sock ) );
+    }
+
+    return ( send_json( sock, "{}" ) );
+}
+
+// Handler for DELETE /profile
+static int handle_profile_delete( int sock, char *req, int oset )
+{
+    if ( !req )
+    {
+        return ( 0 );
+    }
+
+    stats_profile_stop();
+
+    return ( send_json( sock, "{}" ) );
+}
+
+// Route table, from the list in routes.h
+//
+static const WEB_HANDLER routes[] = {
+#define ROUTE( method, uri, handler ) { method, uri, handler },
+#include "routes.h"
+#undef ROUTE
+};
+
+void webserver_run( void )
+{
+    int server_sock;
+    struct sockaddr_in server_addr;
+
+    // The telnet bridge of the ACIA gets its socket before the web server
+    // takes the rest
+    //
+    if ( acia_telnet_setup() )
+    {
+        printf( "Telnet server on port %u\n", TELPORT );
+    }
+
+    server_sock = socket( AF_INET, SOCK_STREAM, 0) ;
+    memset( &server_addr, 0, sizeof( server_addr ) ); 
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = INADDR_ANY; 
+    server_addr.sin_port = htons( HTTPORT );         
+    if ( server_sock < 0 ||
+        bind( server_sock, ( struct sockaddr * )&server_addr, sizeof( server_addr ) ) < 0 ||
+        listen( server_sock, TCP_NUM_SOCKETS ) < 0 )
+    { 
+        perror( "socket/bind/listen failed" ); 
+        return; 
+    }
+    
+    printf( "Web server on port %u\n", HTTPORT );
+    for ( int i = 0; i < sizeof( routes ) / sizeof( routes[0] ); ++i )
+    {
+        web_page_handler( routes[i].method, routes[i].uri, routes[i].handler );
+    }
+
+    trace_setup();
+    crc_setup();
 
     while ( true )
     {
@@ -464,5 +1955,8 @@ void webserver_run( void )
         net_event_poll();
         net_state_poll();
         tcp_socks_poll();
+        watch_poll();
+        mailbox_poll();
+        acia_telnet_poll();
     }
 }
@@ -0,0 +1,274 @@
+/*
+ * WebSocket protocol support for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include "pico/stdlib.h"
+
+#include "picowi.h"
+#include "httpd.h"
+#include "websocket.h"
+
+#define WS_GUID             "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_KEY_LEN          24          // Base64 of a 16 byte nonce
+#define WS_UPGRADE          "Upgrade: websocket\r\n"
+#define WS_ACCEPT           "Sec-WebSocket-Accept: %s\r\n"
+
+static const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static inline uint32_t rol( uint32_t x, int n )
+{
+    return ( ( x << n ) | ( x >> ( 32 - n ) ) );
+}
+
+// SHA-1 block transform (RFC 3174)
+//
+static void sha1_block( uint32_t *h, const uint8_t *p )
+{
+    uint32_t w[80], a, b, c, d, e, f, k, t;
+    int i;
+
+    for ( i = 0; i < 16; ++i )
+    {
+        w[i] = p[4*i] << 24 | p[4*i+1] << 16 | p[4*i+2] << 8 | p[4*i+3];
+    }
+    for ( ; i < 80; ++i )
+    {
+        w[i] = rol( w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1 );
+    }
+
+    a = h[0]; b = h[1]; c = h[2]; d = h[3]; e = h[4];
+
+    for ( i = 0; i < 80; ++i )
+    {
+        if ( i < 20 )
+        {
+            f = ( b & c ) | ( ~b & d );
+            k = 0x5A827999;
+        }
+        else if ( i < 40 )
+        {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        }
+        else if ( i < 60 )
+        {
+            f = ( b & c ) | ( b & d ) | ( c & d );
+            k = 0x8F1BBCDC;
+        }
+        else
+        {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        t = rol( a, 5 ) + f + e + k + w[i];
+        e = d; d = c; c = rol( b, 30 ); b = a; a = t;
+    }
+
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+}
+
+static void sha1( const uint8_t *data, int len, uint8_t *digest )
+{
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    uint8_t block[64];
+    int i, n;
+
+    for ( n = 0; len - n >= 64; n += 64 )
+    {
+        sha1_block( h, &data[n] );
+    }
+
+    // Padding: the rest of the data, a 1 bit and the length in bits, in one
+    // or two blocks
+    //
+    memset( block, 0, sizeof( block ) );
+    memcpy( block, &data[n], len - n );
+    block[len - n] = 0x80;
+
+    if ( len - n > 55 )
+    {
+        sha1_block( h, block );
+        memset( block, 0, sizeof( block ) );
+    }
+
+    for ( i = 0; i < 4; ++i )
+    {
+        block[63 - i] = ( uint32_t ) len * 8 >> ( 8 * i );
+    }
+    sha1_block( h, block );
+
+    for ( i = 0; i < 20; ++i )
+    {
+        digest[i] = h[i / 4] >> ( 24 - 8 * ( i % 4 ) );
+    }
+}
+
+static void base64( const uint8_t *data, int len, char *out )
+{
+    uint32_t v;
+
+    for ( int i = 0; i < len; i += 3 )
+    {
+        v = data[i] << 16 | ( i + 1 < len ? data[i+1] << 8 : 0 ) | ( i + 2 < len ? data[i+2] : 0 );
+        *out++ = base64_chars[v >> 18];
+        *out++ = base64_chars[( v >> 12 ) & 0x3F];
+        *out++ = i + 1 < len ? base64_chars[( v >> 6 ) & 0x3F] : '=';
+        *out++ = i + 2 < len ? base64_chars[v & 0x3F] : '=';
+    }
+    *out = '\0';
+}
+
+// Accept a WebSocket opening handshake (RFC 6455, 4.2) and switch the connection
+// to the WebSocket protocol. Returns the length of the response, or 0 if the
+// request is not a valid handshake, in which case nothing is sent
+//
+int websocket_accept( int sock, http_request_t *http_req )
+{
+    char *upgrade = httpd_get_header( http_req, WEB_HDR_UPGRADE );
+    char *key = httpd_get_header( http_req, WEB_HDR_SEC_WEBSOCKET_KEY );
+    char buf[WS_KEY_LEN + sizeof( WS_GUID ) + 8];
+    char accept[29];
+    uint8_t digest[20];
+    int n;
+
+    if ( !upgrade || strcasecmp( upgrade, "websocket" ) || !key || strlen( key ) != WS_KEY_LEN )
+    {
+        return ( 0 );
+    }
+
+    strcpy( buf, key );
+    strcat( buf, WS_GUID );
+    sha1( ( uint8_t * )buf, strlen( buf ), digest );
+    base64( digest, sizeof( digest ), accept );
+
+    n = web_resp_add_str( sock, HTTP_101_SWITCHING HTTP_SERVER WS_UPGRADE HTTP_CONNECTION_UPGRADE );
+    sprintf( buf, WS_ACCEPT, accept );
+    n += web_resp_add_str( sock, buf );
+    n += web_resp_add_str( sock, HTTP_HEADER_END );
+
+    web_upgrade( sock );
+
+    return ( n );
+}
+
+// Decode a client frame at the start of the buffer (RFC 6455, 5.2). Client
+// frames are always masked, the payload is unmasked in place. Fragmented
+// messages are not supported.
+//
+// Returns the length of the frame, 0 if it is not complete yet or -1 if
+// it is invalid
+//
+int websocket_decode( uint8_t *data, int len, int *opcode, uint8_t **payload, int *plen )
+{
+    int hlen = 6, n;
+
+    if ( len < 2 )
+    {
+        return ( 0 );
+    }
+
+    if ( !( data[0] & 0x80 ) || ( data[0] & 0x70 ) || !( data[1] & 0x80 ) )
+    {
+        return ( -1 );
+    }
+
+    n = data[1] & 0x7F;
+
+    if ( n == 127 )
+    {
+        return ( -1 );
+    }
+
+    if ( n == 126 )
+    {
+        if ( len < 4 )
+        {
+            return ( 0 );
+        }
+        n = data[2] << 8 | data[3];
+        hlen = 8;
+    }
+
+    if ( len < hlen + n )
+    {
+        return ( 0 );
+    }
+
+    for ( int i = 0; i < n; ++i )
+    {
+        data[hlen + i] ^= data[hlen - 4 + ( i & 3 )];
+    }
+
+    *opcode = data[0] & 0x0F;
+    *payload = &data[hlen];
+    *plen = n;
+
+    return ( hlen + n );
+}
+
+// Add an unfragmented frame to the response. Returns its length, or 0 if it
+// does not fit in the segment
+//
+int websocket_add_frame( int sock, int opcode, const uint8_t *payload, int len )
+{
+    NET_SOCKET *ts = &net_sockets[sock];
+    uint8_t header[WS_MAX_HEADER_LEN];
+    int hlen = 2;
+
+    header[0] = 0x80 | opcode;
+
+    if ( len < 126 )
+    {
+        header[1] = len;
+    }
+    else
+    {
+        header[1] = 126;
+        header[2] = len >> 8;
+        header[3] = len & 0xFF;
+        hlen = 4;
+    }
+
+    if ( TCP_DATA_OFFSET + ts->txdlen + hlen + len > TCP_MSS )
+    {
+        return ( 0 );
+    }
+
+    web_resp_add_data( sock, header, hlen );
+    if ( len )
+    {
+        web_resp_add_data( sock, ( BYTE * )payload, len );
+    }
+
+    return ( hlen + len );
+}
+
+// Add a close frame with a status code
+//
+int websocket_add_close( int sock, uint16_t code )
+{
+    uint8_t payload[2] = { code >> 8, code & 0xFF };
+
+    return ( websocket_add_frame( sock, WS_OP_CLOSE, payload, sizeof( payload ) ) );
+}
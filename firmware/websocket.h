@@ -0,0 +1,50 @@
+/*
+ * WebSocket protocol support for the KIM-1 Programmable Memory Board
+ *   https://github.com/eduardocasino/kim-1-programmable-memory-card
+ *
+ *  Copyright (C) 2024 Eduardo Casino
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301, USA.
+ */
+
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <stdint.h>
+#include "httpd.h"
+
+// Frame opcodes (RFC 6455, 5.2)
+//
+#define WS_OP_TEXT          0x1
+#define WS_OP_BINARY        0x2
+#define WS_OP_CLOSE         0x8
+#define WS_OP_PING          0x9
+#define WS_OP_PONG          0xA
+
+// Close status codes (RFC 6455, 7.4.1)
+//
+#define WS_CLOSE_NORMAL     1000
+#define WS_CLOSE_PROTOCOL   1002
+#define WS_CLOSE_TOO_BIG    1009
+
+#define WS_MAX_HEADER_LEN   4           // Server frames, payloads up to 64K
+
+int websocket_accept( int sock, http_request_t *http_req );
+int websocket_decode( uint8_t *data, int len, int *opcode, uint8_t **payload, int *plen );
+int websocket_add_frame( int sock, int opcode, const uint8_t *payload, int len );
+int websocket_add_close( int sock, uint16_t code );
+
+#endif /* WEBSOCKET_H */